@@ -33,6 +33,9 @@ struct rt_bot_internal;
 
 
 namespace BRLCAD {
+    struct BagOfTrianglesIndex;
+
+
     class BRLCAD_COREINTERFACE_EXPORT BagOfTriangles : public Object {
     public:
         enum BotMode {
@@ -56,13 +59,14 @@ namespace BRLCAD {
 
         class BRLCAD_COREINTERFACE_EXPORT Face {
         public:
-            Face(void) : m_bot(0), m_faceIndex(0) {}
-            Face(const Face& original) : m_bot(original.m_bot), m_faceIndex(original.m_faceIndex) {}
+            Face(void) : m_bot(0), m_faceIndex(0), m_index(0) {}
+            Face(const Face& original) : m_bot(original.m_bot), m_faceIndex(original.m_faceIndex), m_index(original.m_index) {}
             ~Face(void) {}
 
             const Face& operator=(const Face& original) {
                 m_bot       = original.m_bot;
                 m_faceIndex = original.m_faceIndex;
+                m_index     = original.m_index;
 
                 return *this;
             }
@@ -92,14 +96,16 @@ namespace BRLCAD {
             }
 
         protected:
-            Face(rt_bot_internal* original,
-                 size_t           originalIndex) : m_bot(original), m_faceIndex(originalIndex) {}
+            Face(rt_bot_internal*     original,
+                 size_t               originalIndex,
+                 BagOfTrianglesIndex* index) : m_bot(original), m_faceIndex(originalIndex), m_index(index) {}
 
             friend BagOfTriangles;
 
         private:
-            rt_bot_internal* m_bot;
-            size_t           m_faceIndex;
+            rt_bot_internal*     m_bot;
+            size_t               m_faceIndex;
+            BagOfTrianglesIndex* m_index;
         };
 
         BotMode               Mode(void) const;
@@ -124,8 +130,52 @@ namespace BRLCAD {
                                       const Vector3D& point2,
                                       const Vector3D& point3);
 
+        /// removes the face, vertices which are no longer used are removed with the next compaction
         void                  DeleteFace(size_t index);
 
+        /// removes the unused vertices and shrinks the arrays to their sizes
+        /** This happens automatically if more than half of the vertices are unused,
+            and when the bag of triangles is written to a database. */
+        void                  Compact(void);
+
+        /// replaces the whole mesh by copies of flat arrays
+        /** vertices has 3 * numberOfVertices, faces 3 * numberOfFaces elements, the faces index into vertices.
+            The optional normals (3 * numberOfNormals elements) are referenced by faceNormals (3 * numberOfFaces elements),
+            the optional thickness has one entry per face.
+            The vertices are taken as they are, i.e. without welding.
+            If normals are given without faceNormals or an index is out of range the mesh stays unchanged. */
+        void                  SetMesh(const double* vertices,
+                                      size_t        numberOfVertices,
+                                      const int*    faces,
+                                      size_t        numberOfFaces,
+                                      const double* normals         = 0,
+                                      size_t        numberOfNormals = 0,
+                                      const int*    faceNormals     = 0,
+                                      const double* thickness       = 0);
+
+        /// like SetMesh() but takes over the arrays which have to be allocated with bu_malloc()
+        /** If the arguments are rejected like in SetMesh() the arrays remain with the caller. */
+        void                  AdoptMesh(double* vertices,
+                                        size_t  numberOfVertices,
+                                        int*    faces,
+                                        size_t  numberOfFaces,
+                                        double* normals         = 0,
+                                        size_t  numberOfNormals = 0,
+                                        int*    faceNormals     = 0,
+                                        double* thickness       = 0);
+
+        /// adds faces given as flat arrays in one pass
+        /** The arguments are like in SetMesh(), the indices in faces and faceNormals start at 0 for the given arrays.
+            The vertices are welded with the existing ones like in AddFace(), invalid arguments are rejected like in SetMesh(). */
+        void                  AppendFaces(const double* vertices,
+                                          size_t        numberOfVertices,
+                                          const int*    faces,
+                                          size_t        numberOfFaces,
+                                          const double* normals         = 0,
+                                          size_t        numberOfNormals = 0,
+                                          const int*    faceNormals     = 0,
+                                          const double* thickness       = 0);
+
         // inherited from BRLCAD::Object
         virtual const Object& operator=(const Object& original);
         virtual Object*       Clone(void) const;
@@ -143,8 +193,10 @@ namespace BRLCAD {
 
     private:
         struct rt_bot_internal *m_internalp;
+        BagOfTrianglesIndex*    m_index;     ///< vertex hash and array capacities, created with the first edit
         const rt_bot_internal* Internal(void) const;
         rt_bot_internal*       Internal(void);
+        BagOfTrianglesIndex&   Index(void);
 
         friend class Database;
     };
@@ -38,10 +38,14 @@
 struct rt_i;
 struct resource;
 struct directory;
+struct db_i;
+struct rt_db_internal;
 
 
 namespace BRLCAD {
     class NonManifoldGeometry;
+    class BagOfTriangles;
+    struct PlotCache;
 
 
     class BRLCAD_COREINTERFACE_EXPORT ConstDatabase {
@@ -129,9 +133,37 @@ namespace BRLCAD {
         /** Do not forget to BRLCAD::Object::Destroy() the non-manifold geometry when you are finished with it! */
         NonManifoldGeometry* Facetize(const char* objectName) const;
 
+        /// facetizes the regions of a single object's tree independently on \a numberOfThreads threads (0: all available processors)
+        /** Every region is tessellated and evaluated on its own, the results are merged in tree walk order into the returned geometry.
+            In contrast to Facetize(const char*) the regions are not unified with each other, i.e. overlapping regions stay overlapping.
+            Do not forget to BRLCAD::Object::Destroy() the non-manifold geometry when you are finished with it! */
+        NonManifoldGeometry* Facetize(const char*  objectName,
+                                      unsigned int numberOfThreads) const;
+
+        /// facetizes the regions of a single object's tree like Facetize(const char*, unsigned int) and returns them as one triangle mesh
+        /** Every region is triangulated and released as soon as it is evaluated, there is no non-manifold geometry of the whole tree.
+            The vertices of the regions are welded with each other.
+            Do not forget to BRLCAD::Object::Destroy() the bag of triangles when you are finished with it! */
+        BagOfTriangles*      FacetizeToTriangles(const char*  objectName,
+                                                 unsigned int numberOfThreads = 0) const;
+
         /// plot a single object's tree and write the resulting wireframe to a vector list
+        /** The wireframe is cached per object and tessellation tolerances, plotting an unchanged tree again only copies it.
+            Database invalidates the cache when an object in the tree is changed.
+            The cache is limited to some MB, the least recently used wireframes are dropped first, and very big
+            wireframes aren't cached at all. */
         void                 Plot(const char* objectName,
                                   VectorList& vectorList) const;
+
+        /// plots the regions of a single object's tree on \a numberOfThreads threads (0: all available processors)
+        /** Every region is plotted into a vector list of its own, these are appended in tree walk order to \a vectorList.
+            The result is the same as with Plot(const char*, VectorList&).
+            The solids whose plot functions only append to their vector list (e.g. the quadrics, arbs, pipes and bags of triangles)
+            are plotted in parallel, the regions with other solids one after another afterwards.
+            Meanwhile librt's vector list free list is put aside, no other thread should release vector lists. */
+        void                 Plot(const char*  objectName,
+                                  VectorList&  vectorList,
+                                  unsigned int numberOfThreads) const;
         //@}
 
         /// @name Active set functions
@@ -140,10 +172,53 @@ namespace BRLCAD {
         /** The function accepts a space separated list of object names too,
             but it is not sure that this behaviour will be kept in future versions. */
         void                 Select(const char* objectName);
+
+        /// adds several database objects to the active set with one tree walk on \a numberOfThreads threads (0: all available processors)
+        /** This is faster than selecting the objects one by one since the solids are loaded and prepared in parallel. */
+        void                 Select(const char** objectNames,
+                                    size_t       numberOfObjectNames,
+                                    unsigned int numberOfThreads = 0);
         /// clear the active set
         void                 UnSelectAll(void);
 
+        /// adds a single object to the active set if it isn't already there
+        /** Objects which were removed with RemoveFromSelection() are still loaded and will be shown again without
+            further work.
+            Before the first ray was shot only the new object will be loaded.
+            librt can't extend an active set which is already prepared for ray tracing however:
+            Adding a new object after this rebuilds the whole active set, i.e. all visible objects are loaded and
+            prepared again.
+            To add several new objects to a prepared active set use UnSelectAll() and Select() with all of them. */
+        void                 AddToSelection(const char* objectName);
+
+        /// hides an object which was added with Select() or AddToSelection()
+        /** The object stays loaded and its regions will be skipped by the ray tracer.
+            The bounding box of the active set doesn't shrink therefore. */
+        void                 RemoveFromSelection(const char* objectName);
+
         bool                 SelectionIsEmpty(void) const;
+
+        /// prepares the active set for ray tracing with \a numberOfThreads threads (0: all available processors)
+        /** Without calling this function the preparation will be done with the first bounding box request or ray.
+            Concurrent calls are safe, the first one does the work and the others wait for it. */
+        void                 Prepare(unsigned int numberOfThreads = 0) const;
+
+        struct PrepStatistics {
+            double selectTime;       ///< seconds spent in Select() since the last UnSelectAll(), librt does the tree walk and the solid prep there
+            double prepTime;         ///< seconds spent in the last preparation: region setup and space partitioning
+            size_t numberOfSolids;
+            size_t numberOfRegions;
+            size_t numberOfCutNodes; ///< inner nodes of the space partitioning tree
+            size_t numberOfBoxNodes; ///< leaves of the space partitioning tree
+            size_t maximumCutDepth;
+
+            PrepStatistics(void) : selectTime(0.), prepTime(0.), numberOfSolids(0), numberOfRegions(0), numberOfCutNodes(0),
+                                   numberOfBoxNodes(0), maximumCutDepth(0) {}
+        };
+
+        /// the values which depend on the preparation are 0 as long as the active set isn't prepared
+        PrepStatistics       PreparationStatistics(void) const;
+
         Vector3D             BoundingBoxMinima(void) const;
         Vector3D             BoundingBoxMaxima(void) const;
 
@@ -207,11 +282,188 @@ namespace BRLCAD {
                                       int          flags) const;
         //@}
 
+        /// @name Multi-threaded ray tracing
+        //@{
+        /// makes sure that at least \a numberOfSlots resource slots are available for concurrent ray tracing
+        /** Every thread which shoots rays at the same time has to use its own slot.
+            Slot 0 is the one used by the ShootRay() functions without a slot parameter.
+            Do not call this function while other threads are shooting rays. */
+        void                 ReserveThreadSlots(size_t numberOfSlots) const;
+        size_t               NumberOfThreadSlots(void) const;
+
+        /// thread-safe variant of ShootRay(), \a threadSlot has to be below NumberOfThreadSlots()
+        /** The selection will be prepared for ray tracing if necessary.
+            The callback will be called from the thread which called this function. */
+        void                 ShootRay(const Ray3D& ray,
+                                      HitCallback& callback,
+                                      int          flags,
+                                      size_t       threadSlot) const;
+
+
+        class BatchHitCallback {
+        public:
+            virtual ~BatchHitCallback(void) {}
+
+            /** \a rayIndex is the position of the ray in the array given to ShootRays()
+                return true: go on with this ray; false: stop this ray */
+            /** This method will be called from several threads at the same time.
+                Do not throw en exception here. */
+            virtual bool operator()(size_t     rayIndex,
+                                    const Hit& hit) = 0;
+
+        protected:
+            BatchHitCallback(void) {}
+            BatchHitCallback(const BatchHitCallback&) {}
+            const BatchHitCallback& operator=(const BatchHitCallback&) {return *this;}
+        };
+
+        /// shoots \a numberOfRays rays distributed over \a numberOfThreads threads
+        /** With \a numberOfThreads == 0 all available processors will be used.
+            The selection is prepared once before the rays are shot.
+            Do not call this function while other threads are shooting rays at this database. */
+        void                 ShootRays(const Ray3D*      rays,
+                                       size_t            numberOfRays,
+                                       BatchHitCallback& callback,
+                                       int               flags,
+                                       unsigned int      numberOfThreads = 0) const;
+
+
+        /// caller provided column storage for hits as an alternative to the HitCallback
+        /** Only the arrays selected by the fields argument of ShootRay() or ShootRays() are written, they have to hold
+            capacity entries (points and normals: 3 doubles per entry).
+            The ray tracer appends at numberOfHits and increments it by the number of hits found.
+            If numberOfHits exceeds capacity the surplus hits were dropped. */
+        struct HitBuffer {
+            size_t  capacity;
+            size_t  numberOfHits;
+            size_t* rayIndex;
+            double* distanceIn;
+            double* distanceOut;
+            int*    regionId;
+            double* pointIn;
+            double* pointOut;
+            double* surfaceNormalIn;
+            double* surfaceNormalOut;
+
+            HitBuffer(void) : capacity(0), numberOfHits(0), rayIndex(0), distanceIn(0), distanceOut(0), regionId(0),
+                              pointIn(0), pointOut(0), surfaceNormalIn(0), surfaceNormalOut(0) {}
+        };
+
+        static const int HitRayIndex       = 1;
+        static const int HitDistances      = 2;  ///< distanceIn and distanceOut
+        static const int HitRegionIds      = 4;
+        static const int HitPoints         = 8;  ///< pointIn and pointOut
+        static const int HitSurfaceNormals = 16; ///< surfaceNormalIn and surfaceNormalOut
+
+        /// writes the hits of a single ray to \a buffer, only the columns in \a fields will be computed
+        void                 ShootRay(const Ray3D& ray,
+                                      HitBuffer&   buffer,
+                                      int          fields,
+                                      int          flags,
+                                      size_t       threadSlot = 0) const;
+
+        /// writes the hits of all rays to \a buffer, use HitRayIndex to assign them to the rays
+        /** The order of the hits in the buffer is not determined across the rays. */
+        void                 ShootRays(const Ray3D* rays,
+                                       size_t       numberOfRays,
+                                       HitBuffer&   buffer,
+                                       int          fields,
+                                       int          flags,
+                                       unsigned int numberOfThreads = 0) const;
+
+        //@}
+
+        /// @name Visibility queries
+        //@{
+        /// tests if the ray hits the active set within \a maxDistance from its origin
+        /** Only the existence of the first hit is determined, no hit object or surface normal will be computed.
+            \a threadSlot has to be below NumberOfThreadSlots(). */
+        bool                 Occluded(const Ray3D& ray,
+                                      double       maxDistance,
+                                      size_t       threadSlot = 0) const;
+
+        /// computes the distance from the ray's origin to its first hit
+        /** Returns false if the ray misses the active set.
+            The distance is 0 if the origin is inside of a region. */
+        bool                 FirstHitDistance(const Ray3D& ray,
+                                              double&      distance,
+                                              size_t       threadSlot = 0) const;
+
+        /// Occluded() for \a numberOfRays rays distributed over \a numberOfThreads threads (0: all available processors)
+        void                 Occluded(const Ray3D*  rays,
+                                      const double* maxDistances,
+                                      size_t        numberOfRays,
+                                      bool*         results,
+                                      unsigned int  numberOfThreads = 0) const;
+
+        /// FirstHitDistance() for \a numberOfRays rays, the distances of the rays with hits[i] == false are undefined
+        void                 FirstHitDistances(const Ray3D* rays,
+                                               size_t       numberOfRays,
+                                               bool*        hits,
+                                               double*      distances,
+                                               unsigned int numberOfThreads = 0) const;
+        //@}
+
     protected:
-        rt_i*     m_rtip;
-        resource* m_resp;
+        rt_i*              m_rtip;
+        resource*          m_resp;
+        resource**         m_resources;               ///< one resource per thread slot, m_resources[0] == m_resp
+        mutable size_t     m_numberOfResources;
+        double             m_selectTime;
+        mutable double     m_prepTime;
+        char**             m_selectedObjects;         ///< names given to Select() and AddToSelection()
+        bool*              m_selectedObjectHidden;    ///< removed by RemoveFromSelection()
+        size_t             m_numberOfSelectedObjects;
+        mutable PlotCache* m_plotCache;               ///< wireframes of the plotted objects, created with the first Plot()
+
+        /// (re-)registers the resources of all thread slots at m_rtip and resets the prep statistics, the selection list and the plot cache
+        /** Has to be called after m_rtip was changed. */
+        void                 InitResources(void);
+
+        /// drops the cached wireframes of all objects which contain \a pDir in their tree (0: all wireframes)
+        void                 InvalidatePlotCache(const directory* pDir) const;
+
+        /// wraps the librt internal \a intern of type \a id of the object \a pDir and hands it over to \a callback
+        void                 HandOverObject(directory*      pDir,
+                                            rt_db_internal& intern,
+                                            int             id,
+                                            ObjectCallback& callback) const;
 
     private:
+        bool                 PlotFromCache(const char* objectName,
+                                           VectorList& vectorList) const;
+        void                 AddToPlotCache(const char*       objectName,
+                                            const VectorList& plot) const;
+        void                 AppendToSelectionList(const char* objectName);
+        void                 ClearSelectionList(void);
+        void                 UpdateHiddenRegions(void);
+        void                 Reselect(void);
+
+        void                 ShootRaysIntern(const Ray3D*      rays,
+                                             size_t            numberOfRays,
+                                             BatchHitCallback* callback,
+                                             HitBuffer*        buffer,
+                                             int               fields,
+                                             bool*             hits,
+                                             double*           distances,
+                                             const double*     maxDistances,
+                                             int               flags,
+                                             unsigned int      numberOfThreads) const;
+
+        /// facetizes the regions of \a objectName in parallel into either \a nonManifoldGeometry or \a triangles
+        void                 FacetizeIntern(const char*          objectName,
+                                            unsigned int         numberOfThreads,
+                                            NonManifoldGeometry* nonManifoldGeometry,
+                                            BagOfTriangles*      triangles) const;
+
+        /// calls \a callback with the wrapper of type \a T around \a ip
+        template<class T>
+        static void          CallWithObject(resource*       resp,
+                                            directory*      pDir,
+                                            rt_db_internal* ip,
+                                            db_i*           dbip,
+                                            ObjectCallback& callback);
+
         ConstDatabase(const ConstDatabase&);                  // not implemented
         const ConstDatabase& operator=(const ConstDatabase&); // not implemented
     };
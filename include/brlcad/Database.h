@@ -37,6 +37,9 @@ struct rt_wdb;
 
 
 namespace BRLCAD {
+    struct DatabaseTransaction;
+
+
     class BRLCAD_COREINTERFACE_EXPORT Database : public ConstDatabase {
     public:
         virtual ~Database(void);
@@ -72,20 +75,49 @@ namespace BRLCAD {
         };
 
         /// selects a single object and hand it over to an ObjectCallback (for read and write)
+        /** Returns false if the object doesn't exist or couldn't be written.
+            In a transaction the callback gets the object with its changes collected so far. */
         bool         Get(const char*     objectName,
                          ObjectCallback& callback);
 
         /// provided for convenience: selects a single object and sets it to \a object
-        /** The type of the object in the database and \a object must match. */
+        /** The type of the object in the database and \a object must match.
+            Like Get(), Set() returns false if there is no object with the name of \a object. */
         bool         Set(const Object& object);
         //@}
 
+        /// @name Transactions
+        //@{
+        /// starts to collect the changes of Add(), Get() with an ObjectCallback, Set() and Delete() in memory
+        /** The database itself stays unchanged until Commit(), i.e. the functions of ConstDatabase see the state before the transaction.
+            Get() with an ObjectCallback and Set() however see the collected changes:
+            They continue the edits of an object changed or added in the transaction and fail for a deleted one.
+            An object's latest change replaces its earlier ones.
+            Renaming an object in a transaction is not supported, Object::SetName() keeps the name of an object handed over by Get() then.
+            Calling BeginTransaction() during a transaction has no effect. */
+        void         BeginTransaction(void);
+
+        /// writes the collected changes in one pass, every object with its attributes in a single record
+        /** Returns false if one of the changes could not be written, the others are written nevertheless. */
+        bool         Commit(void);
+
+        /// discards the collected changes
+        void         Rollback(void);
+
+        bool         InTransaction(void) const;
+        //@}
+
     protected:
-        rt_wdb* m_wdbp;
+        rt_wdb*              m_wdbp;
+        DatabaseTransaction* m_transaction; ///< the collected changes between BeginTransaction() and Commit() or Rollback()
 
         Database(void);
 
     private:
+        /// returns a copy of the librt internal of \a object, which has to be of type \a T
+        template<class T>
+        static void* CloneInternal(const Object& object);
+
         Database(const Database&);                  // not implemented
         const Database& operator=(const Database&); // not implemented
     };
@@ -42,7 +42,8 @@ namespace BRLCAD {
 
         /// loads a BRL-CAD database file (*.g) into the memory
         /** The old content of the in-memory database will be discarded.
-            The file will be opened for reading only and closed after finishing the operation. */
+            The file will be opened for reading only and closed after finishing the operation.
+            The objects are copied in their stored form, without decoding them. */
         virtual bool Load(const char* fileName);
         bool         Load(const void* data,
                           size_t      dataSize);
@@ -133,6 +133,7 @@ namespace BRLCAD {
         // holds Objects's name if not connected to a database
         char*                   m_name;
         bu_attribute_value_set* m_avs;
+        bool                    m_fixedName; ///< SetName() doesn't rename the object in the database, e.g. during a transaction
 
         const bu_attribute_value_set* GetAvs(void) const;
         bu_attribute_value_set*       GetAvs(bool create);
@@ -42,6 +42,8 @@ namespace BRLCAD {
 
         const Pipe&           operator=(const Pipe& original);
 
+        class ControlPointIterator;
+
         class BRLCAD_COREINTERFACE_EXPORT ControlPoint {
         public:
             ControlPoint(void) : m_pipe(0), m_controlPoint(0) {}
@@ -79,10 +81,44 @@ namespace BRLCAD {
                          wdb_pipe_pnt*     controlPoint) : m_pipe(pipe), m_controlPoint(controlPoint) {}
 
             friend class Pipe;
+            friend class ControlPointIterator;
+        };
+
+        /// walks through the control points of a pipe from the first to the last one
+        /** The iterator becomes invalid (operator void*() returns 0) after the last control point. */
+        class BRLCAD_COREINTERFACE_EXPORT ControlPointIterator {
+        public:
+            ControlPointIterator(void) : m_pipe(0), m_controlPoint(0) {}
+            ControlPointIterator(const ControlPointIterator& original) : m_pipe(original.m_pipe), m_controlPoint(original.m_controlPoint) {}
+            ~ControlPointIterator(void) {}
+
+            const ControlPointIterator& operator=(const ControlPointIterator& original) {
+                m_pipe         = original.m_pipe;
+                m_controlPoint = original.m_controlPoint;
+
+                return *this;
+            }
+
+                                        operator void*(void) {
+                return m_controlPoint;
+            }
+
+            const ControlPointIterator& operator++(void);
+            ControlPoint                operator*(void) const;
+
+        private:
+            rt_pipe_internal* m_pipe;
+            wdb_pipe_pnt*     m_controlPoint;
+
+            ControlPointIterator(rt_pipe_internal* pipe,
+                                 wdb_pipe_pnt*     controlPoint) : m_pipe(pipe), m_controlPoint(controlPoint) {}
+
+            friend class Pipe;
         };
 
         size_t                NumberOfControlPoints(void) const;
         ControlPoint          GetControlPoint(size_t index);
+        ControlPointIterator  FirstControlPoint(void);
         ControlPoint          AppendControlPoint(const Vector3D& point,
                                                  double          innerDiameter,
                                                  double          outerDiameter,
@@ -94,6 +130,14 @@ namespace BRLCAD {
                                                  double          bendRadius);
         void                  DeleteControlPoint(size_t index);
 
+        /// replaces all control points
+        /** points has 3 * numberOfControlPoints elements, the other arrays one per control point. */
+        void                  SetControlPoints(const double* points,
+                                               const double* innerDiameters,
+                                               const double* outerDiameters,
+                                               const double* bendRadii,
+                                               size_t        numberOfControlPoints);
+
         // inherited from BRLCAD::Object
         virtual const Object& operator=(const Object& original);
         virtual Object*       Clone(void) const;
@@ -112,8 +156,14 @@ namespace BRLCAD {
     private:
         rt_pipe_internal* m_internalp;
 
+        // index of the control points in the list of the rt_pipe_internal
+        wdb_pipe_pnt**    m_controlPoints;
+        size_t            m_controlPointsCapacity;
+        bool              m_controlPointsValid;
+
         const rt_pipe_internal* Internal(void) const;
         rt_pipe_internal*       Internal(void);
+        wdb_pipe_pnt**          ControlPoints(void);
 
         friend class Database;
     };
@@ -37,6 +37,9 @@ struct bezier_seg;
 
 
 namespace BRLCAD {
+    struct SketchIndex;
+
+
     class BRLCAD_COREINTERFACE_EXPORT Sketch : public Object {
     public:
         Sketch(void);
@@ -69,12 +72,21 @@ namespace BRLCAD {
 
         protected:
             rt_sketch_internal* m_sketch;
+            SketchIndex**       m_index;  ///< the index pointer of the sketch, the first edit creates the index
+
+            Segment(void) : m_sketch(0), m_index(0)  {}
+            Segment(const Segment& original) : m_sketch(original.m_sketch), m_index(original.m_index) {}
+            Segment(rt_sketch_internal* sketch,
+                    SketchIndex**       index) : m_sketch(sketch), m_index(index) {}
 
-            Segment(void) : m_sketch(0)  {}
-            Segment(const Segment& original) : m_sketch(original.m_sketch) {}
-            Segment(rt_sketch_internal* sketch) : m_sketch(sketch) {}
+            const Segment& operator=(const Segment& original) {
+                m_sketch = original.m_sketch;
+                m_index  = original.m_index;
+                return *this;
+            }
 
-            const Segment& operator=(const Segment& original) {return *this;}
+            /// the librt segment, identifies the segment in the sketch
+            virtual const void* SegmentInternal(void) const = 0;
         };
 
         class BRLCAD_COREINTERFACE_EXPORT Line : public Segment {
@@ -100,8 +112,11 @@ namespace BRLCAD {
         private:
             line_seg* m_lineSegment;
 
+            virtual const void* SegmentInternal(void) const;
+
             Line(line_seg*           lineSegment,
-                 rt_sketch_internal* sketch) : Segment(sketch), m_lineSegment(lineSegment) {}
+                 rt_sketch_internal* sketch,
+                 SketchIndex**       index) : Segment(sketch, index), m_lineSegment(lineSegment) {}
             friend class Sketch;
         };
 
@@ -137,8 +152,11 @@ namespace BRLCAD {
         private:
             carc_seg* m_circularArcSegment;
 
+            virtual const void* SegmentInternal(void) const;
+
             CircularArc(carc_seg*           circularArcSegment,
-                        rt_sketch_internal* sketch) : Segment(sketch), m_circularArcSegment(circularArcSegment) {}
+                        rt_sketch_internal* sketch,
+                        SketchIndex**       index) : Segment(sketch, index), m_circularArcSegment(circularArcSegment) {}
             friend class Sketch;
         };
 
@@ -178,8 +196,11 @@ namespace BRLCAD {
         private:
             nurb_seg* m_nurbSegment;
 
+            virtual const void* SegmentInternal(void) const;
+
             Nurb(nurb_seg*           nurbSegment,
-                 rt_sketch_internal* sketch) : Segment(sketch), m_nurbSegment(nurbSegment) {}
+                 rt_sketch_internal* sketch,
+                 SketchIndex**       index) : Segment(sketch, index), m_nurbSegment(nurbSegment) {}
 
             friend class Sketch;
         };
@@ -211,8 +232,11 @@ namespace BRLCAD {
         private:
             bezier_seg* m_bezierSegment;
 
+            virtual const void* SegmentInternal(void) const;
+
             Bezier(bezier_seg*         bezierSegment,
-                   rt_sketch_internal* sketch) : Segment(sketch), m_bezierSegment(bezierSegment) {}
+                   rt_sketch_internal* sketch,
+                   SketchIndex**       index) : Segment(sketch, index), m_bezierSegment(bezierSegment) {}
 
             friend class Sketch;
         };
@@ -264,8 +288,57 @@ namespace BRLCAD {
         Bezier*               AppendBezier(void);
         Bezier*               InsertBezier(size_t index);
 
+        /// appends line segments given as flat arrays
+        /** vertices has 2 * numberOfVertices elements, lines 2 * numberOfLines (start and end point) indices into vertices.
+            The vertices are welded with the existing ones. */
+        void                  AppendLines(const double* vertices,
+                                          size_t        numberOfVertices,
+                                          const int*    lines,
+                                          size_t        numberOfLines);
+
+        /// appends circular arcs given as flat arrays
+        /** arcs has 2 * numberOfArcs (start and end point) indices into vertices,
+            radii, centersAreLeft, clockwiseOriented and centers (indices into vertices) have one entry per arc
+            (the last three are optional). */
+        void                  AppendArcs(const double* vertices,
+                                         size_t        numberOfVertices,
+                                         const int*    arcs,
+                                         const double* radii,
+                                         size_t        numberOfArcs,
+                                         const bool*   centersAreLeft    = 0,
+                                         const bool*   clockwiseOriented = 0,
+                                         const int*    centers           = 0);
+
+        /// appends Bezier curves given as flat arrays
+        /** The control points of all curves are concatenated in controlPoints, a curve of degree n has n + 1 of them. */
+        void                  AppendBeziers(const double* vertices,
+                                            size_t        numberOfVertices,
+                                            const int*    controlPoints,
+                                            const size_t* degrees,
+                                            size_t        numberOfBeziers);
+
+        /// appends NURB curves given as flat arrays
+        /** The control points, their optional weights, and the knots of all curves are concatenated. */
+        void                  AppendNurbs(const double* vertices,
+                                          size_t        numberOfVertices,
+                                          const int*    controlPoints,
+                                          const size_t* numberOfControlPoints,
+                                          const size_t* orders,
+                                          const double* knots,
+                                          const size_t* numberOfKnots,
+                                          size_t        numberOfNurbs,
+                                          const double* weights = 0);
+
         void                  DeleteSegment(size_t index);
 
+        /// number of vertices including the unused ones which are left until the next compaction
+        size_t                NumberOfVertices(void) const;
+
+        /// removes the vertices which are no longer used by a segment
+        /** This happens automatically if more than half of the vertices are unused after DeleteSegment() or
+            after moving a point of a segment. */
+        void                  Compact(void);
+
         Vector3D              EmbeddingPlaneX(void) const;
         Vector3D              EmbeddingPlaneY(void) const;
         void                  SetEmbeddingPlaneX(Vector3D& u);
@@ -291,9 +364,11 @@ namespace BRLCAD {
     private:
         // holds Objects's content if not connected to a database
         rt_sketch_internal* m_internalp;
+        SketchIndex*        m_index;     ///< vertex hash, usage counts and array capacities, created with the first edit
 
         const rt_sketch_internal* Internal(void) const;
         rt_sketch_internal*       Internal(void);
+        SketchIndex&              Index(void);
 
         friend class Database;
     };
@@ -495,7 +495,55 @@ namespace BRLCAD {
         void              Iterate(ConstElementCallback& callBack) const;
         void              Iterate(ElementCallback& callBack);
 
+        /// number of elements (drawing commands) in the list
+        size_t            NumberOfElements(void) const;
+
+        /// number of line strips in the list
+        /** A line strip is a LineMove (or a LineDraw not preceded by
+            another line element) together with the LineDraws directly
+            following it. */
+        size_t            NumberOfLineStrips(void) const;
+
+        /// copies the whole list into flat, caller provided arrays
+        /** The list is traversed once, without creating Element objects.
+            Each of the arrays may be 0, otherwise it has to be large enough:
+            - \a positions: 3 * NumberOfElements() coordinates, the vector
+              of every element as it is stored (e.g. the point of a
+              LineDraw, the normal of a PolygonStart, the size of a
+              PointSize in the first coordinate)
+            - \a types: NumberOfElements() Element::ElementType values,
+              commands unknown to this interface are reported as 255
+            - \a stripStarts, \a stripLengths: NumberOfLineStrips() element
+              indices and element counts of the line strips */
+        void              Export(double*        positions,
+                                 unsigned char* types,
+                                 size_t*        stripStarts  = 0,
+                                 size_t*        stripLengths = 0) const;
+        void              Export(float*         positions,
+                                 unsigned char* types,
+                                 size_t*        stripStarts  = 0,
+                                 size_t*        stripLengths = 0) const;
+
         bool              Append(const Element& element);
+
+        /// appends line strips given as consecutive xyz triples
+        /** The first point of every strip becomes a LineMove, the following
+            ones LineDraws.  \a stripLengths holds the number of points of
+            each strip. */
+        bool              AppendLines(const double* points,
+                                      const size_t* stripLengths,
+                                      size_t        numberOfStrips);
+
+        /// appends polygons given as consecutive xyz triples
+        /** Every polygon is written as PolygonStart, PolygonMove,
+            PolygonDraws and PolygonEnd.  \a normals holds one xyz normal
+            per polygon; if it is 0 the normals are computed from the
+            vertices (Newell's method). */
+        bool              AppendPolygons(const double* points,
+                                         const size_t* polygonLengths,
+                                         size_t        numberOfPolygons,
+                                         const double* normals = 0);
+
         void              Clear(void);
 
     private:
@@ -28,8 +28,6 @@
  *      implementation of the graphical visualization
  */
 
-#include <cmath>
-
 #include <QPainter>
 
 #include "GraphicView.h"
@@ -40,12 +38,25 @@ GraphicView::GraphicView
     BRLCAD::ConstDatabase& database,
     QWidget*               parent
 ) : QWidget(parent),
-    m_database(database),
+    m_renderEngine(0),
     m_transformation(),
     m_image(),
-    m_imageUpTodate(false),
-    m_updatingImage(false) {
+    m_imageUpTodate(false) {
     setMinimumSize(100, 100);
+
+    m_renderEngine = new RenderEngine(database, this);
+
+    // the finished tiles are streamed to the screen while the others are still in work
+    connect(m_renderEngine,
+            &RenderEngine::TileFinished,
+            this,
+            static_cast<void (QWidget::*)(const QRect&)>(&QWidget::update));
+}
+
+
+GraphicView::~GraphicView(void) {
+    // the workers write into m_image which will be destroyed before the child objects
+    m_renderEngine->Cancel();
 }
 
 
@@ -65,15 +76,30 @@ void GraphicView::UpdateTrafo(const QMatrix4x4& transformation) {
 }
 
 
+void GraphicView::SetProgressiveRendering
+(
+    bool progressive
+) {
+    if (progressive != m_renderEngine->Progressive()) {
+        m_renderEngine->SetProgressive(progressive);
+
+        Update();
+    }
+}
+
+
+void GraphicView::CancelRendering(void) {
+    m_renderEngine->Cancel();
+}
+
+
 void GraphicView::paintEvent
 (
     QPaintEvent*
 ) {
-    if (!m_imageUpTodate && !m_updatingImage) {
-        m_updatingImage = true;
+    if (!m_imageUpTodate) {
         UpdateImage();
         m_imageUpTodate = true;
-        m_updatingImage = false;
     }
 
     QPainter painter(this);
@@ -81,79 +107,22 @@ void GraphicView::paintEvent
 }
 
 
-class RayTraceCallback : public BRLCAD::ConstDatabase::HitCallback {
-public:
-    RayTraceCallback(const QVector3D& direction) : BRLCAD::ConstDatabase::HitCallback(), m_direction(direction), m_color(Qt::white) {}
-
-    virtual bool operator()(const BRLCAD::ConstDatabase::Hit& hit) throw() {
-        double    brightness         = 0;
-        double    ambient            = 0.1;
-        double    diffuseWeight      = 0.5;
-        double    specularWeight     = 0.5;
-        int       n                  = 4;
-        QVector3D normal             = QVector3D(hit.SurfaceNormalIn().coordinates[0], hit.SurfaceNormalIn().coordinates[1], hit.SurfaceNormalIn().coordinates[2]);
-        double    dotProduct         = QVector3D::dotProduct(m_direction, normal); // negative because of opposite directions
-
-        // value from 0 to 1
-        double    diffuse            = -dotProduct;
-
-        // refleced = incidence - 2 normal
-        QVector3D reflectedDir       = m_direction - 2. * dotProduct * normal;
-        reflectedDir.normalize();
-
-        // value from 0 to 1
-        double    reflectedDotCamDir = std::max(0.f, QVector3D::dotProduct(reflectedDir, m_direction));
-        double    specular           = pow(reflectedDotCamDir, n);
-
-        brightness += ambient + diffuse * diffuseWeight;
-
-        double    red                = std::min(hit.Red() * brightness + specular * specularWeight, 1.0);
-        double    green              = std::min(hit.Green() * brightness + specular * specularWeight, 1.0);
-        double    blue               = std::min(hit.Blue() * brightness + specular * specularWeight, 1.0);
+void GraphicView::resizeEvent
+(
+    QResizeEvent*
+) {
+    Update();
+}
 
-        m_color.setRgbF(red, green, blue);
 
-        return false;
-    }
+void GraphicView::UpdateImage(void) {
+    m_renderEngine->Cancel();
 
-    const QColor& Color(void) const {
-        return m_color;
+    // keep the old image as background for the new tiles if possible
+    if (m_image.size() != size()) {
+        m_image = QImage(width(), height(), QImage::Format_RGB32);
+        m_image.fill(Qt::white);
     }
 
-private:
-    QVector3D m_direction;
-    QColor    m_color;
-};
-
-
-void GraphicView::UpdateImage(void) {
-    int w  = width();
-    int h = height();
-
-    m_image = QImage(w, h, QImage::Format_RGB32);
-
-    QVector3D directionStart = m_transformation.map(QVector3D(0., 0., 1.));
-    QVector3D directionEnd   = m_transformation.map(QVector3D(0., 0., 0.));
-    QVector3D direction      = directionEnd - directionStart;
-    direction.normalize();
-
-    for (int column = 0; column < w; column++) {
-        for (int row = 0; row < h; row++) {
-            QVector3D        imagePoint(column, h - row - 1., 0.);
-            QVector3D        modelPoint = m_transformation.map(imagePoint);
-            RayTraceCallback callback(direction);
-            BRLCAD::Ray3D    ray;
-
-            ray.origin.coordinates[0]    = modelPoint.x();
-            ray.origin.coordinates[1]    = modelPoint.y();
-            ray.origin.coordinates[2]    = modelPoint.z();
-            ray.direction.coordinates[0] = direction.x();
-            ray.direction.coordinates[1] = direction.y();
-            ray.direction.coordinates[2] = direction.z();
-
-            m_database.ShootRay(ray, callback, BRLCAD::ConstDatabase::StopAfterFirstHit);
-
-            m_image.setPixelColor(column, row, callback.Color());
-        }
-    }
+    m_renderEngine->Start(m_image, m_transformation);
 }
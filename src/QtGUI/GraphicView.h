@@ -36,26 +36,35 @@
 
 #include <brlcad/ConstDatabase.h>
 
+#include "RenderEngine.h"
+
 
 class GraphicView : public QWidget {
     Q_OBJECT
 public:
     GraphicView(BRLCAD::ConstDatabase& database,
                 QWidget*               parent = 0);
+    virtual ~GraphicView(void);
 
 public slots:
     void Update(void);
     void UpdateTrafo(const QMatrix4x4& transformation);
 
+    /// switches between progressive refinement and full resolution ray tracing, default is progressive
+    void SetProgressiveRendering(bool progressive);
+
+    /// stops the ray tracing in flight, has to be called before the database or its active set will be changed
+    void CancelRendering(void);
+
 protected:
     virtual void paintEvent(QPaintEvent* event);
+    virtual void resizeEvent(QResizeEvent* event);
 
 private:
-    BRLCAD::ConstDatabase& m_database;
-    QMatrix4x4             m_transformation;
-    QImage                 m_image;
-    bool                   m_imageUpTodate;
-    bool                   m_updatingImage;
+    RenderEngine* m_renderEngine;
+    QMatrix4x4    m_transformation;
+    QImage        m_image;
+    bool          m_imageUpTodate;
 
     void UpdateImage(void);
 };
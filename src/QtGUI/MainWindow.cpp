@@ -78,6 +78,7 @@ MainWindow::MainWindow
     logWidget->setWidget(m_logView);
     addDockWidget(Qt::BottomDockWidgetArea, logWidget);
 
+    connect(m_objectsTreeView, &ObjectsTreeView::SelectionAboutToChange, m_graphicView, &GraphicView::CancelRendering);
     connect(m_objectsTreeView, &ObjectsTreeView::SelectionChanged, m_graphicView, &GraphicView::Update);
     connect(m_cameraView, &CameraView::Changed, m_graphicView, &GraphicView::UpdateTrafo);
 
@@ -99,6 +100,8 @@ void MainWindow::LoadDatabase
 (
     const char* fileName
 ) {
+    m_graphicView->CancelRendering();
+
     if (m_database.Load(fileName))  {
         QString title = m_database.Title();
 
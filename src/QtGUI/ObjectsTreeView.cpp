@@ -112,15 +112,22 @@ void ObjectsTreeView::Rebuild(void) {
 
 
 void ObjectsTreeView::Activated(const QItemSelection & selected, const QItemSelection & deselected) {
-    QModelIndexList selectedIndexes;
+    QModelIndexList selectedIndexes   = selected.indexes();
+    QModelIndexList deselectedIndexes = deselected.indexes();
 
-    m_database.UnSelectAll();
-    selectedIndexes = selectionModel()->selectedIndexes();
+    emit SelectionAboutToChange();
+
+    // only the difference, the database keeps the other objects prepared
+    for (int i = 0; i < deselectedIndexes.size(); i++) {
+        const QModelIndex deselectedIndex = deselectedIndexes.at(i);
+
+        m_database.RemoveFromSelection(m_objectsTree->itemFromIndex(deselectedIndex)->text().toUtf8().data());
+    }
 
     for (int i = 0; i < selectedIndexes.size(); i++) {
         const QModelIndex selectedIndex = selectedIndexes.at(i);
 
-        m_database.Select(m_objectsTree->itemFromIndex(selectedIndex)->text().toUtf8().data());
+        m_database.AddToSelection(m_objectsTree->itemFromIndex(selectedIndex)->text().toUtf8().data());
     }
 
     emit SelectionChanged();
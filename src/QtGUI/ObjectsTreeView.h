@@ -46,6 +46,7 @@ public:
     void Rebuild(void);
 
 signals:
+    void SelectionAboutToChange(void);
     void SelectionChanged(void);
 
 private:
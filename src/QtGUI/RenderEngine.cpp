@@ -0,0 +1,435 @@
+/*                     R E N D E R E N G I N E . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2018 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/** @file RenderEngine.cpp
+ *
+ *  BRL-CAD Qt GUI:
+ *      implementation of the multi-threaded tile renderer
+ */
+
+#include <cmath>
+
+#include <QThread>
+
+#include "RenderEngine.h"
+
+
+// edge length of the square tiles in pixels, a multiple of the coarsest sample distance
+static const int TileSize = 32;
+
+// sample distance in pixels of the first pass in progressive mode
+static const int CoarsestStep = 8;
+
+// minimal cosine between the surface normals of samples to interpolate between them
+static const float SimilarNormals = 0.98f;
+
+
+class RenderWorker : public QThread {
+public:
+    RenderWorker(RenderEngine& engine,
+                 size_t        threadSlot) : QThread(), m_engine(engine), m_threadSlot(threadSlot) {}
+
+protected:
+    virtual void run(void) {
+        m_engine.RenderTiles(m_threadSlot);
+    }
+
+private:
+    RenderEngine& m_engine;
+    size_t        m_threadSlot;
+};
+
+
+RenderEngine::RenderEngine
+(
+    const BRLCAD::ConstDatabase& database,
+    QObject*                     parent
+) : QObject(parent),
+    m_database(database),
+    m_workers(),
+    m_progressive(true),
+    m_transformation(),
+    m_direction(),
+    m_bits(0),
+    m_bytesPerLine(0),
+    m_width(0),
+    m_height(0),
+    m_tilesPerRow(0),
+    m_numberOfTiles(0),
+    m_firstStep(1),
+    m_numberOfPasses(1),
+    m_nextTile(0),
+    m_finishedTiles(0),
+    m_cancel(0),
+    m_passMutex(),
+    m_passFinished(),
+    m_sampleRegions(),
+    m_sampleNormals(),
+    m_regions(0),
+    m_normals(0) {
+    int numberOfWorkers = QThread::idealThreadCount();
+
+    if (numberOfWorkers < 1)
+        numberOfWorkers = 1;
+
+    for (int i = 0; i < numberOfWorkers; ++i)
+        m_workers.append(new RenderWorker(*this, i));
+}
+
+
+RenderEngine::~RenderEngine(void) {
+    Cancel();
+
+    for (int i = 0; i < m_workers.size(); ++i)
+        delete m_workers[i];
+}
+
+
+void RenderEngine::Start
+(
+    QImage&           image,
+    const QMatrix4x4& transformation
+) {
+    Cancel();
+
+    m_transformation = transformation;
+
+    QVector3D directionStart = m_transformation.map(QVector3D(0., 0., 1.));
+    QVector3D directionEnd   = m_transformation.map(QVector3D(0., 0., 0.));
+
+    m_direction = directionEnd - directionStart;
+    m_direction.normalize();
+
+    // bits() detaches the image, therefore it has to be called here and not in the workers
+    m_bits          = image.bits();
+    m_bytesPerLine  = image.bytesPerLine();
+    m_width         = image.width();
+    m_height        = image.height();
+    m_tilesPerRow   = (m_width + TileSize - 1) / TileSize;
+    m_numberOfTiles = m_tilesPerRow * ((m_height + TileSize - 1) / TileSize);
+
+    if (m_progressive) {
+        m_firstStep      = CoarsestStep;
+        m_numberOfPasses = 0;
+
+        for (int step = CoarsestStep; step > 0; step /= 2)
+            ++m_numberOfPasses;
+
+        // the same as for the image: the workers shouldn't call data()
+        m_sampleRegions.resize(m_width * m_height);
+        m_sampleNormals.resize(m_width * m_height);
+        m_regions = m_sampleRegions.data();
+        m_normals = m_sampleNormals.data();
+    }
+    else {
+        m_firstStep      = 1;
+        m_numberOfPasses = 1;
+    }
+
+    m_nextTile.store(0);
+    m_finishedTiles.store(0);
+
+    if ((m_numberOfTiles > 0) && !m_database.SelectionIsEmpty()) {
+        m_database.ReserveThreadSlots(m_workers.size());
+
+        int numberOfWorkers = m_workers.size();
+
+        if (static_cast<size_t>(numberOfWorkers) > m_database.NumberOfThreadSlots())
+            numberOfWorkers = static_cast<int>(m_database.NumberOfThreadSlots());
+
+        for (int i = 0; i < numberOfWorkers; ++i)
+            m_workers[i]->start();
+    }
+    else
+        image.fill(Qt::white);
+}
+
+
+void RenderEngine::Cancel(void) {
+    m_cancel.store(1);
+
+    // wake up the workers waiting for the end of a pass
+    m_passMutex.lock();
+    m_passFinished.wakeAll();
+    m_passMutex.unlock();
+
+    for (int i = 0; i < m_workers.size(); ++i)
+        m_workers[i]->wait();
+
+    m_cancel.store(0);
+}
+
+
+void RenderEngine::SetProgressive
+(
+    bool progressive
+) {
+    m_progressive = progressive;
+}
+
+
+bool RenderEngine::Progressive(void) const {
+    return m_progressive;
+}
+
+
+void RenderEngine::RenderTiles
+(
+    size_t threadSlot
+) {
+    // the first worker prepares the active set with all of them, the others wait for it
+    m_database.Prepare(m_workers.size());
+
+    while (m_cancel.load() == 0) {
+        int ticket = m_nextTile.fetchAndAddOrdered(1);
+        int pass   = ticket / m_numberOfTiles;
+
+        if (pass >= m_numberOfPasses)
+            break;
+
+        // a refinement pass reads the samples of the previous one in the neighbouring tiles too
+        if (!WaitForPass(pass))
+            break;
+
+        int   tileIndex = ticket % m_numberOfTiles;
+        int   left      = (tileIndex % m_tilesPerRow) * TileSize;
+        int   top       = (tileIndex / m_tilesPerRow) * TileSize;
+        QRect tile(left, top, std::min(TileSize, m_width - left), std::min(TileSize, m_height - top));
+
+        RenderTile(tile, m_firstStep >> pass, pass > 0, threadSlot);
+
+        if (m_cancel.load() == 0)
+            emit TileFinished(tile);
+
+        int finishedTiles = m_finishedTiles.fetchAndAddOrdered(1) + 1;
+
+        if ((finishedTiles % m_numberOfTiles) == 0) {
+            m_passMutex.lock();
+            m_passFinished.wakeAll();
+            m_passMutex.unlock();
+        }
+    }
+}
+
+
+bool RenderEngine::WaitForPass
+(
+    int pass
+) {
+    m_passMutex.lock();
+
+    while ((m_finishedTiles.load() < pass * m_numberOfTiles) && (m_cancel.load() == 0))
+        m_passFinished.wait(&m_passMutex);
+
+    m_passMutex.unlock();
+
+    return m_cancel.load() == 0;
+}
+
+
+class RayTraceCallback : public BRLCAD::ConstDatabase::HitCallback {
+public:
+    RayTraceCallback(const QVector3D& direction) : BRLCAD::ConstDatabase::HitCallback(), m_direction(direction), m_color(Qt::white), m_region(0), m_normal() {}
+
+    virtual bool operator()(const BRLCAD::ConstDatabase::Hit& hit) throw() {
+        double    brightness         = 0;
+        double    ambient            = 0.1;
+        double    diffuseWeight      = 0.5;
+        double    specularWeight     = 0.5;
+        int       n                  = 4;
+        QVector3D normal             = QVector3D(hit.SurfaceNormalIn().coordinates[0], hit.SurfaceNormalIn().coordinates[1], hit.SurfaceNormalIn().coordinates[2]);
+        double    dotProduct         = QVector3D::dotProduct(m_direction, normal); // negative because of opposite directions
+
+        // value from 0 to 1
+        double    diffuse            = -dotProduct;
+
+        // refleced = incidence - 2 normal
+        QVector3D reflectedDir       = m_direction - 2. * dotProduct * normal;
+        reflectedDir.normalize();
+
+        // value from 0 to 1
+        double    reflectedDotCamDir = std::max(0.f, QVector3D::dotProduct(reflectedDir, m_direction));
+        double    specular           = pow(reflectedDotCamDir, n);
+
+        brightness += ambient + diffuse * diffuseWeight;
+
+        double    red                = std::min(hit.Red() * brightness + specular * specularWeight, 1.0);
+        double    green              = std::min(hit.Green() * brightness + specular * specularWeight, 1.0);
+        double    blue               = std::min(hit.Blue() * brightness + specular * specularWeight, 1.0);
+
+        m_color.setRgbF(red, green, blue);
+
+        // the name is stored in the region, therefore the pointer identifies it
+        m_region = hit.Name();
+        m_normal = normal;
+
+        return false;
+    }
+
+    const QColor& Color(void) const {
+        return m_color;
+    }
+
+    const char* Region(void) const {
+        return m_region;
+    }
+
+    const QVector3D& Normal(void) const {
+        return m_normal;
+    }
+
+private:
+    QVector3D   m_direction;
+    QColor      m_color;
+    const char* m_region;
+    QVector3D   m_normal;
+};
+
+
+QRgb RenderEngine::TracePixel
+(
+    int    column,
+    int    row,
+    size_t threadSlot
+) {
+    QVector3D        imagePoint(column, m_height - row - 1., 0.);
+    QVector3D        modelPoint = m_transformation.map(imagePoint);
+    RayTraceCallback callback(m_direction);
+    BRLCAD::Ray3D    ray;
+
+    ray.origin.coordinates[0]    = modelPoint.x();
+    ray.origin.coordinates[1]    = modelPoint.y();
+    ray.origin.coordinates[2]    = modelPoint.z();
+    ray.direction.coordinates[0] = m_direction.x();
+    ray.direction.coordinates[1] = m_direction.y();
+    ray.direction.coordinates[2] = m_direction.z();
+
+    m_database.ShootRay(ray, callback, BRLCAD::ConstDatabase::StopAfterFirstHit, threadSlot);
+
+    if (m_numberOfPasses > 1) {
+        int index = row * m_width + column;
+
+        m_regions[index] = callback.Region();
+        m_normals[index] = callback.Normal();
+    }
+
+    return callback.Color().rgb();
+}
+
+
+/// interpolates the pixel's color bilinearly from the corners of the sample cell around it
+/** Returns false if the corners don't hit the same region with similar surface normals. */
+bool RenderEngine::Interpolate
+(
+    int   column,
+    int   row,
+    int   cellSize,
+    QRgb& color
+) {
+    int column0 = column - column % cellSize;
+    int row0    = row - row % cellSize;
+    int column1 = std::min(column0 + cellSize, ((m_width - 1) / cellSize) * cellSize);
+    int row1    = std::min(row0 + cellSize, ((m_height - 1) / cellSize) * cellSize);
+    int corners[4] = {row0 * m_width + column0, row0 * m_width + column1, row1 * m_width + column0, row1 * m_width + column1};
+
+    const char*      region = m_regions[corners[0]];
+    const QVector3D& normal = m_normals[corners[0]];
+
+    for (int i = 1; i < 4; ++i) {
+        if (m_regions[corners[i]] != region)
+            return false;
+
+        if ((region != 0) && (QVector3D::dotProduct(m_normals[corners[i]], normal) < SimilarNormals))
+            return false;
+    }
+
+    QRgb  cornerColors[4];
+    float x = (column1 > column0) ? static_cast<float>(column - column0) / (column1 - column0) : 0.f;
+    float y = (row1 > row0) ? static_cast<float>(row - row0) / (row1 - row0) : 0.f;
+
+    cornerColors[0] = reinterpret_cast<const QRgb*>(m_bits + row0 * m_bytesPerLine)[column0];
+    cornerColors[1] = reinterpret_cast<const QRgb*>(m_bits + row0 * m_bytesPerLine)[column1];
+    cornerColors[2] = reinterpret_cast<const QRgb*>(m_bits + row1 * m_bytesPerLine)[column0];
+    cornerColors[3] = reinterpret_cast<const QRgb*>(m_bits + row1 * m_bytesPerLine)[column1];
+
+    float weights[4] = {(1.f - x) * (1.f - y), x * (1.f - y), (1.f - x) * y, x * y};
+    float red        = 0.f;
+    float green      = 0.f;
+    float blue       = 0.f;
+
+    for (int i = 0; i < 4; ++i) {
+        red   += weights[i] * qRed(cornerColors[i]);
+        green += weights[i] * qGreen(cornerColors[i]);
+        blue  += weights[i] * qBlue(cornerColors[i]);
+    }
+
+    color = qRgb(qRound(red), qRound(green), qRound(blue));
+
+    // the interpolated pixel is a sample for the next pass
+    int index = row * m_width + column;
+
+    m_regions[index] = region;
+    m_normals[index] = normal;
+
+    return true;
+}
+
+
+/** Traces the pixels of the tile on a grid with distance step and fills the step x step block right below each
+    with its color.
+    If refine is set the pixels on the grid with the distance 2 * step are known from the previous pass and will
+    be skipped, the others are interpolated if possible. */
+void RenderEngine::RenderTile
+(
+    const QRect& tile,
+    int          step,
+    bool         refine,
+    size_t       threadSlot
+) {
+    for (int row = tile.top(); row <= tile.bottom(); row += step) {
+        for (int column = tile.left(); column <= tile.right(); column += step) {
+            if (refine && ((row % (2 * step)) == 0) && ((column % (2 * step)) == 0))
+                continue;
+
+            QRgb color;
+
+            if (!refine || !Interpolate(column, row, 2 * step, color))
+                color = TracePixel(column, row, threadSlot);
+
+            // write directly into the scanlines, QImage::setPixelColor() isn't thread-safe
+            int blockBottom = std::min(row + step - 1, tile.bottom());
+            int blockRight  = std::min(column + step - 1, tile.right());
+
+            for (int blockRow = row; blockRow <= blockBottom; ++blockRow) {
+                QRgb* scanLine = reinterpret_cast<QRgb*>(m_bits + blockRow * m_bytesPerLine);
+
+                for (int blockColumn = column; blockColumn <= blockRight; ++blockColumn)
+                    scanLine[blockColumn] = color;
+            }
+        }
+
+        if (m_cancel.load() != 0)
+            break;
+    }
+}
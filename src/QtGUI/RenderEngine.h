@@ -0,0 +1,120 @@
+/*                       R E N D E R E N G I N E . H
+ * BRL-CAD
+ *
+ * Copyright (c) 2018 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * Permission is hereby granted, free of charge, to any person obtaining a copy
+ * of this software and associated documentation files (the "Software"), to deal
+ * in the Software without restriction, including without limitation the rights
+ * to use, copy, modify, merge, publish, distribute, sublicense, and/or sell
+ * copies of the Software, and to permit persons to whom the Software is
+ * furnished to do so, subject to the following conditions:
+ *
+ * The above copyright notice and this permission notice shall be included in all
+ * copies or substantial portions of the Software.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE AND NONINFRINGEMENT. IN NO EVENT SHALL THE
+ * AUTHORS OR COPYRIGHT HOLDERS BE LIABLE FOR ANY CLAIM, DAMAGES OR OTHER
+ * LIABILITY, WHETHER IN AN ACTION OF CONTRACT, TORT OR OTHERWISE, ARISING FROM,
+ * OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER DEALINGS IN THE
+ * SOFTWARE.
+ */
+/** @file RenderEngine.h
+ *
+ *  BRL-CAD Qt GUI:
+ *      declaration of the multi-threaded tile renderer
+ */
+
+#ifndef RENDERENGINE_H
+#define RENDERENGINE_H
+
+#include <QObject>
+#include <QImage>
+#include <QMatrix4x4>
+#include <QVector>
+#include <QAtomicInt>
+#include <QMutex>
+#include <QWaitCondition>
+
+#include <brlcad/ConstDatabase.h>
+
+
+class RenderWorker;
+
+
+class RenderEngine : public QObject {
+    Q_OBJECT
+public:
+    RenderEngine(const BRLCAD::ConstDatabase& database,
+                 QObject*                     parent = 0);
+    virtual ~RenderEngine(void);
+
+    /// starts ray tracing the active set into image, a rendering in flight will be canceled
+    /** The function returns immediately, the tiles are traced by a pool of worker threads.
+        The image must neither be resized nor destroyed before the rendering was finished or canceled,
+        and the database must not be changed meanwhile. */
+    void Start(QImage&           image,
+               const QMatrix4x4& transformation);
+
+    /// stops the rendering in flight and returns after all workers have finished
+    void Cancel(void);
+
+    /// progressive mode: a coarse grid is traced first and refined in successive passes
+    /** In the refinement passes pixels in an area where all surrounding samples hit the same region with similar
+        surface normals are interpolated instead of being traced.
+        Takes effect with the next Start(). */
+    void SetProgressive(bool progressive);
+    bool Progressive(void) const;
+
+signals:
+    /// emitted from the worker threads, the pixels of tile were updated by a pass
+    void TileFinished(const QRect& tile);
+
+private:
+    const BRLCAD::ConstDatabase& m_database;
+    QVector<RenderWorker*>       m_workers;
+    bool                         m_progressive;
+    QMatrix4x4                   m_transformation;
+    QVector3D                    m_direction;
+    uchar*                       m_bits;
+    int                          m_bytesPerLine;
+    int                          m_width;
+    int                          m_height;
+    int                          m_tilesPerRow;
+    int                          m_numberOfTiles;
+    int                          m_firstStep;
+    int                          m_numberOfPasses;
+    QAtomicInt                   m_nextTile;     ///< over all passes: pass * m_numberOfTiles + tile
+    QAtomicInt                   m_finishedTiles;
+    QAtomicInt                   m_cancel;
+    QMutex                       m_passMutex;
+    QWaitCondition               m_passFinished;
+
+    /// per pixel: region hit by the sample (0 for a miss) and its surface normal
+    QVector<const char*>         m_sampleRegions;
+    QVector<QVector3D>           m_sampleNormals;
+    const char**                 m_regions;      ///< m_sampleRegions.data() for the workers
+    QVector3D*                   m_normals;      ///< m_sampleNormals.data() for the workers
+
+    void RenderTiles(size_t threadSlot);
+    bool WaitForPass(int pass);
+    void RenderTile(const QRect& tile,
+                    int          step,
+                    bool         refine,
+                    size_t       threadSlot);
+    QRgb TracePixel(int    column,
+                    int    row,
+                    size_t threadSlot);
+    bool Interpolate(int   column,
+                     int   row,
+                     int   cellSize,
+                     QRgb& color);
+
+    friend class RenderWorker;
+};
+
+
+#endif // RENDERENGINE_H
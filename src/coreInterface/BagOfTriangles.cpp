@@ -25,6 +25,7 @@
 
 #include <cstring>
 #include <cassert>
+#include <cmath>
 
 #include "raytrace.h"
 #include "rt/geom.h"
@@ -38,85 +39,398 @@
 using namespace BRLCAD;
 
 
-static int AddVertex
+namespace BRLCAD {
+    /// editing state of a rt_bot_internal which is kept beside it
+    /** The arrays of the rt_bot_internal may be bigger than their number of elements (librt uses the numbers only)
+        to let them grow geometrically.
+        The vertices are found via a hash table over a grid with the cell size VertexCellSize.
+        Vertices which are no longer used by any face stay in the bot until CompactVertices() removes them. */
+    struct BagOfTrianglesIndex {
+        size_t verticesCapacity;    ///< in vertices
+        size_t facesCapacity;       ///< in faces
+        size_t thicknessCapacity;   ///< in faces
+        size_t faceNormalsCapacity; ///< in faces
+        bool   hashValid;           ///< the hash table contains all vertices of the bot
+        size_t numberOfBuckets;     ///< a power of 2
+        int*   buckets;             ///< first vertex in the bucket, -1 if empty
+        int*   nextVertices;        ///< next vertex in the same bucket, -1 at the end, verticesCapacity entries
+        bool   usageValid;          ///< vertexUsage and numberOfUnusedVertices are up to date
+        int*   vertexUsage;         ///< number of face corners referencing the vertex, verticesCapacity entries
+        size_t numberOfUnusedVertices;
+    };
+}
+
+
+// has to be bigger than the welding tolerance VUNITIZE_TOL and small enough to keep the cell coordinates in the int64_t range
+static const double VertexCellSize = 1.e-6;
+
+
+static void* Reserve
 (
-    const point_t&   point,
-    rt_bot_internal& bot
+    void*       array,
+    size_t&     capacity,
+    size_t      numberOfElements,
+    size_t      elementSize,
+    const char* label
 ) {
-    int ret = 0; // index of the added vertex
+    void* ret = array;
 
-    // vertex already there?
-    for (; ret < bot.num_vertices; ++ret) {
-        fastf_t tmp[3] = {bot.vertices[ret * 3], bot.vertices[ret * 3 + 1], bot.vertices[ret * 3 + 2]};
+    if ((numberOfElements > capacity) || (array == 0)) {
+        size_t newCapacity = 2 * capacity;
 
-        if (VNEAR_EQUAL(point, tmp, VUNITIZE_TOL))
-            break;
+        if (newCapacity < numberOfElements)
+            newCapacity = numberOfElements;
+
+        if (newCapacity < 1)
+            newCapacity = 1;
+
+        ret      = bu_realloc(array, newCapacity * elementSize, label);
+        capacity = newCapacity;
+    }
+
+    return ret;
+}
+
+
+static void InvalidateHash
+(
+    BagOfTrianglesIndex& index
+) {
+    if (index.buckets != 0) {
+        bu_free(index.buckets, "bot interface InvalidateHash(): buckets");
+        index.buckets = 0;
+    }
+
+    if (index.nextVertices != 0) {
+        bu_free(index.nextVertices, "bot interface InvalidateHash(): nextVertices");
+        index.nextVertices = 0;
+    }
+
+    index.numberOfBuckets = 0;
+    index.hashValid       = false;
+}
+
+
+static void InvalidateVertexUsage
+(
+    BagOfTrianglesIndex& index
+) {
+    if (index.vertexUsage != 0) {
+        bu_free(index.vertexUsage, "bot interface InvalidateVertexUsage(): vertexUsage");
+        index.vertexUsage = 0;
     }
 
-    if (ret == bot.num_vertices) {
+    index.numberOfUnusedVertices = 0;
+    index.usageValid             = false;
+}
+
+
+/// the arrays of the bot have their exact sizes, e.g. after a copy
+static void ResetIndex
+(
+    BagOfTrianglesIndex&   index,
+    const rt_bot_internal& bot
+) {
+    InvalidateHash(index);
+    InvalidateVertexUsage(index);
+
+    index.verticesCapacity    = bot.num_vertices;
+    index.facesCapacity       = bot.num_faces;
+    index.thicknessCapacity   = (bot.thickness != 0) ? bot.num_faces : 0;
+    index.faceNormalsCapacity = (bot.face_normals != 0) ? bot.num_face_normals : 0;
+}
+
+
+static int64_t VertexCell
+(
+    fastf_t coordinate
+) {
+    return static_cast<int64_t>(floor(coordinate / VertexCellSize));
+}
+
+
+static size_t CellBucket
+(
+    int64_t x,
+    int64_t y,
+    int64_t z,
+    size_t  numberOfBuckets
+) {
+    uint64_t hash = (static_cast<uint64_t>(x) * 73856093U) ^ (static_cast<uint64_t>(y) * 19349663U) ^ (static_cast<uint64_t>(z) * 83492791U);
+
+    return static_cast<size_t>(hash & (numberOfBuckets - 1));
+}
+
+
+static void HashVertex
+(
+    BagOfTrianglesIndex&   index,
+    const rt_bot_internal& bot,
+    int                    vertex
+) {
+    const fastf_t* point  = bot.vertices + vertex * 3;
+    size_t         bucket = CellBucket(VertexCell(point[0]), VertexCell(point[1]), VertexCell(point[2]), index.numberOfBuckets);
+
+    index.nextVertices[vertex] = index.buckets[bucket];
+    index.buckets[bucket]      = vertex;
+}
+
+
+/// (re-)builds the hash table with at least one bucket per vertex
+static void BuildHash
+(
+    BagOfTrianglesIndex&   index,
+    const rt_bot_internal& bot
+) {
+    size_t numberOfBuckets = 64;
+
+    while (numberOfBuckets < bot.num_vertices)
+        numberOfBuckets *= 2;
+
+    if (index.buckets != 0)
+        bu_free(index.buckets, "bot interface BuildHash(): buckets");
+
+    index.buckets         = static_cast<int*>(bu_malloc(numberOfBuckets * sizeof(int), "bot interface BuildHash(): buckets"));
+    index.numberOfBuckets = numberOfBuckets;
+
+    for (size_t i = 0; i < numberOfBuckets; ++i)
+        index.buckets[i] = -1;
+
+    size_t capacity = index.verticesCapacity;
+
+    if (capacity < bot.num_vertices)
+        capacity = bot.num_vertices;
+
+    if (capacity < 1)
+        capacity = 1;
+
+    index.nextVertices = static_cast<int*>(bu_realloc(index.nextVertices, capacity * sizeof(int), "bot interface BuildHash(): nextVertices"));
+
+    for (int i = 0; i < static_cast<int>(bot.num_vertices); ++i)
+        HashVertex(index, bot, i);
+
+    index.hashValid = true;
+}
+
+
+static int FindVertex
+(
+    const point_t&         point,
+    BagOfTrianglesIndex&   index,
+    const rt_bot_internal& bot
+) {
+    int ret = -1;
+
+    if (!index.hashValid)
+        BuildHash(index, bot);
+
+    // the vertices within the tolerance may be in the neighbour cells
+    int64_t minCell[3];
+    int64_t maxCell[3];
+
+    for (int i = 0; i < 3; ++i) {
+        minCell[i] = VertexCell(point[i] - VUNITIZE_TOL);
+        maxCell[i] = VertexCell(point[i] + VUNITIZE_TOL);
+    }
+
+    for (int64_t x = minCell[0]; (x <= maxCell[0]) && (ret < 0); ++x) {
+        for (int64_t y = minCell[1]; (y <= maxCell[1]) && (ret < 0); ++y) {
+            for (int64_t z = minCell[2]; (z <= maxCell[2]) && (ret < 0); ++z) {
+                for (int vertex = index.buckets[CellBucket(x, y, z, index.numberOfBuckets)]; vertex >= 0; vertex = index.nextVertices[vertex]) {
+                    fastf_t tmp[3] = {bot.vertices[vertex * 3], bot.vertices[vertex * 3 + 1], bot.vertices[vertex * 3 + 2]};
+
+                    if (VNEAR_EQUAL(point, tmp, VUNITIZE_TOL)) {
+                        ret = vertex;
+                        break;
+                    }
+                }
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+/// counts the references of the faces to the vertices
+static void BuildVertexUsage
+(
+    BagOfTrianglesIndex&   index,
+    const rt_bot_internal& bot
+) {
+    size_t capacity = index.verticesCapacity;
+
+    if (capacity < bot.num_vertices)
+        capacity = bot.num_vertices;
+
+    if (capacity < 1)
+        capacity = 1;
+
+    index.vertexUsage = static_cast<int*>(bu_realloc(index.vertexUsage, capacity * sizeof(int), "bot interface BuildVertexUsage(): vertexUsage"));
+    memset(index.vertexUsage, 0, capacity * sizeof(int));
+
+    for (size_t i = 0; i < 3 * bot.num_faces; ++i)
+        ++index.vertexUsage[bot.faces[i]];
+
+    index.numberOfUnusedVertices = 0;
+
+    for (size_t i = 0; i < bot.num_vertices; ++i) {
+        if (index.vertexUsage[i] == 0)
+            ++index.numberOfUnusedVertices;
+    }
+
+    index.usageValid = true;
+}
+
+
+static void UseVertex
+(
+    BagOfTrianglesIndex& index,
+    int                  vertex
+) {
+    if (index.usageValid) {
+        if (index.vertexUsage[vertex] == 0)
+            --index.numberOfUnusedVertices;
+
+        ++index.vertexUsage[vertex];
+    }
+}
+
+
+static void ReleaseVertex
+(
+    BagOfTrianglesIndex& index,
+    int                  vertex
+) {
+    if (index.usageValid) {
+        assert(index.vertexUsage[vertex] > 0);
+
+        --index.vertexUsage[vertex];
+
+        if (index.vertexUsage[vertex] == 0)
+            ++index.numberOfUnusedVertices;
+    }
+}
+
+
+/// adds a vertex or returns an existing one within the tolerance
+/** The caller has to register the usage of the returned vertex with UseVertex(). */
+static int AddVertex
+(
+    const point_t&       point,
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex& index
+) {
+    int ret = FindVertex(point, index, bot); // index of the added vertex
+
+    if (ret < 0) {
         // add a new vertex
+        ret = static_cast<int>(bot.num_vertices);
+
+        size_t verticesCapacity = index.verticesCapacity;
+
+        bot.vertices = static_cast<fastf_t*>(Reserve(bot.vertices, index.verticesCapacity, bot.num_vertices + 1, 3 * sizeof(fastf_t), "bot interface AddVertex(): vertices"));
+
+        if (index.verticesCapacity != verticesCapacity) {
+            index.nextVertices = static_cast<int*>(bu_realloc(index.nextVertices, index.verticesCapacity * sizeof(int), "bot interface AddVertex(): nextVertices"));
+
+            if (index.usageValid)
+                index.vertexUsage = static_cast<int*>(bu_realloc(index.vertexUsage, index.verticesCapacity * sizeof(int), "bot interface AddVertex(): vertexUsage"));
+        }
+
+        if (index.usageValid) {
+            index.vertexUsage[ret] = 0;
+            ++index.numberOfUnusedVertices;
+        }
+
         ++bot.num_vertices;
-        bot.vertices = static_cast<fastf_t*>(bu_realloc(bot.vertices, bot.num_vertices * 3 * sizeof(fastf_t), "bot interface AddVertex()"));
         bot.vertices[ret * 3]     = point[0];
         bot.vertices[ret * 3 + 1] = point[1];
         bot.vertices[ret * 3 + 2] = point[2];
+
+        if (bot.num_vertices > index.numberOfBuckets)
+            BuildHash(index, bot);
+        else
+            HashVertex(index, bot, ret);
     }
 
     return ret;
 }
 
 
-static void RemoveVertex
+/// removes all vertices which aren't used by a face in one pass
+static void CompactVertices
 (
-    int              index,
-    rt_bot_internal& bot
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex* botIndex = 0
 ) {
-    assert(index < bot.num_vertices);
+    if (bot.num_vertices > 0) {
+        int* newIndices = static_cast<int*>(bu_calloc(bot.num_vertices, sizeof(int), "bot interface CompactVertices(): newIndices"));
+
+        for (size_t i = 0; i < 3 * bot.num_faces; ++i)
+            newIndices[bot.faces[i]] = 1;
+
+        size_t numberOfVertices = 0;
 
-    if (index < bot.num_vertices) {
-        // is the vertex used elsewhere?
-        size_t vertexUsage = 0;
+        for (size_t i = 0; i < bot.num_vertices; ++i) {
+            if (newIndices[i] != 0) {
+                if (numberOfVertices < i)
+                    memcpy(bot.vertices + numberOfVertices * 3, bot.vertices + i * 3, 3 * sizeof(fastf_t));
 
-        for (int i = 0; i < (3 * bot.num_faces); ++i) {
-            if (bot.faces[i] == index)
-                vertexUsage++;
+                newIndices[i] = static_cast<int>(numberOfVertices);
+                ++numberOfVertices;
+            }
         }
 
-        if (vertexUsage <= 1) {
-            // really remove it
-            memcpy(bot.vertices + index * 3, bot.vertices + (index + 1) * 3, (bot.num_vertices - index - 1) * 3 * sizeof(fastf_t));
+        if (numberOfVertices < bot.num_vertices) {
+            for (size_t i = 0; i < 3 * bot.num_faces; ++i)
+                bot.faces[i] = newIndices[bot.faces[i]];
+
+            bot.num_vertices = numberOfVertices;
+
+            if (botIndex != 0) {
+                InvalidateHash(*botIndex);
+
+                if (botIndex->usageValid) {
+                    // the usage counts move with the vertices
+                    for (size_t i = 0; i < bot.num_vertices; ++i)
+                        botIndex->vertexUsage[i] = 0;
 
-            --bot.num_vertices;
-            bot.vertices = static_cast<fastf_t*>(bu_realloc(bot.vertices, bot.num_vertices * 3 * sizeof(fastf_t), "bot interface RemoveVertex()"));
+                    for (size_t i = 0; i < 3 * bot.num_faces; ++i)
+                        ++botIndex->vertexUsage[bot.faces[i]];
 
-            // update faces
-            for (int i = 0; i < (3 * bot.num_faces); ++i) {
-                if (bot.faces[i] > index)
-                    --bot.faces[i];
+                    botIndex->numberOfUnusedVertices = 0;
+                }
             }
+            else if (numberOfVertices > 0)
+                bot.vertices = static_cast<fastf_t*>(bu_realloc(bot.vertices, bot.num_vertices * 3 * sizeof(fastf_t), "bot interface CompactVertices()"));
         }
+
+        bu_free(newIndices, "bot interface CompactVertices(): newIndices");
     }
 }
 
 
 static int SwapVertex
 (
-    int              oldIndex,
-    const point_t&   newPoint,
-    rt_bot_internal& bot
+    int                  oldIndex,
+    const point_t&       newPoint,
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex& index
 ) {
     int     ret; // index of the new vertex
     fastf_t tmp[3];
-    tmp[0] = bot.vertices[oldIndex];
-    tmp[1] = bot.vertices[oldIndex + 1];
-    tmp[2] = bot.vertices[oldIndex + 2];
+    tmp[0] = bot.vertices[oldIndex * 3];
+    tmp[1] = bot.vertices[oldIndex * 3 + 1];
+    tmp[2] = bot.vertices[oldIndex * 3 + 2];
 
     if (VNEAR_EQUAL(newPoint, tmp, VUNITIZE_TOL))
         ret = oldIndex;
     else {
-        RemoveVertex(oldIndex, bot);
+        ReleaseVertex(index, oldIndex);
 
-        ret = AddVertex(newPoint, bot);
+        ret = AddVertex(newPoint, bot, index);
+        UseVertex(index, ret);
     }
 
     return ret;
@@ -213,15 +527,23 @@ static int SwapNormal
 
 static void EnsureFaceNormals
 (
-    rt_bot_internal& bot
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex* index = 0
 ) {
     assert(bot.num_faces >= bot.num_face_normals);
 
     if (bot.num_faces > 0) {
-        if (bot.face_normals == 0)
+        if (bot.face_normals == 0) {
             bot.face_normals = static_cast<int*>(bu_calloc(3 * bot.num_faces, sizeof(int), "bot interface EnsureFaceNormals(): face_normals"));
+
+            if (index != 0)
+                index->faceNormalsCapacity = bot.num_faces;
+        }
         else if (bot.num_faces > bot.num_face_normals) {
-            bot.face_normals = static_cast<int*>(bu_realloc(bot.face_normals, 3 * bot.num_faces * sizeof(int), "bot interface EnsureFaceNormals(): face_normals"));
+            if (index != 0)
+                bot.face_normals = static_cast<int*>(Reserve(bot.face_normals, index->faceNormalsCapacity, bot.num_faces, 3 * sizeof(int), "bot interface EnsureFaceNormals(): face_normals"));
+            else
+                bot.face_normals = static_cast<int*>(bu_realloc(bot.face_normals, 3 * bot.num_faces * sizeof(int), "bot interface EnsureFaceNormals(): face_normals"));
 
             for (size_t i = bot.num_face_normals; i < bot.num_faces; ++i) {
                 fastf_t defaultNormal[3] = {0};
@@ -368,23 +690,7 @@ void CleanUpBotInternal
     RT_BOT_CK_MAGIC(&bot);
 
     // remove unused vertices
-    int vertexCount = 0;
-
-    while (vertexCount < bot.num_vertices) {
-        bool inUse = false;
-
-        for (int i = 0; i < (3 * bot.num_faces); ++i) {
-            if (bot.faces[i] == vertexCount) {
-                inUse = true;
-                break;
-            }
-        }
-
-        if (!inUse)
-            RemoveVertex(vertexCount, bot);
-        else
-            ++vertexCount;
-    }
+    CompactVertices(bot);
 
     // remove unused normals
     if ((bot.normals != 0) && (bot.face_normals != 0)) {
@@ -441,61 +747,257 @@ void CleanUpBotInternal
 
 void RemoveFace
 (
-    size_t           index,
-    rt_bot_internal& bot
+    size_t               index,
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex* botIndex = 0
 ) {
+    // with an index the arrays keep their capacity
     if (bot.num_faces > (index + 1))
-        memcpy(bot.faces + index * 3, bot.faces + index * 3 + 3, (bot.num_faces - index - 1) * 3 * sizeof(int));
+        memmove(bot.faces + index * 3, bot.faces + index * 3 + 3, (bot.num_faces - index - 1) * 3 * sizeof(int));
 
-    bot.faces = static_cast<int*>(bu_realloc(bot.faces, (bot.num_faces - 1) * 3 * sizeof(int), "bot interface RemoveFace(): faces"));
+    if (botIndex == 0)
+        bot.faces = static_cast<int*>(bu_realloc(bot.faces, (bot.num_faces - 1) * 3 * sizeof(int), "bot interface RemoveFace(): faces"));
 
     if (bot.thickness != 0) {
         assert(bot.mode != RT_BOT_SURFACE);
         assert(bot.mode != RT_BOT_SOLID);
 
-        memcpy(bot.thickness + index, bot.thickness + index + 1, (bot.num_faces - index - 1) * sizeof(fastf_t));
-        bot.thickness = static_cast<fastf_t*>(bu_realloc(bot.thickness, (bot.num_faces - 1) * sizeof(fastf_t), "bot interface RemoveFace(): thickness"));
+        memmove(bot.thickness + index, bot.thickness + index + 1, (bot.num_faces - index - 1) * sizeof(fastf_t));
+
+        if (botIndex == 0)
+            bot.thickness = static_cast<fastf_t*>(bu_realloc(bot.thickness, (bot.num_faces - 1) * sizeof(fastf_t), "bot interface RemoveFace(): thickness"));
     }
 
     if (bot.face_mode != 0) {
         assert(bot.mode != RT_BOT_SURFACE);
         assert(bot.mode != RT_BOT_SOLID);
 
-        bu_bitv* temp = bu_bitv_new(bot.num_faces - 1);
-
-        for (size_t i = 0; i < index; ++i) {
+        // shifted in place, the bit vector keeps its size until BagOfTriangles::Compact()
+        for (size_t i = (index + 1); i < bot.num_faces; ++i) {
             if (BU_BITTEST(bot.face_mode, i))
-                BU_BITSET(temp, i);
+                BU_BITSET(bot.face_mode, i - 1);
             else
-                BU_BITCLR(temp, i);
+                BU_BITCLR(bot.face_mode, i - 1);
         }
 
-        for (size_t i = (index + 1); i < bot.num_faces; ++i) {
+        BU_BITCLR(bot.face_mode, bot.num_faces - 1);
+    }
+
+    if ((bot.face_normals != 0) && (bot.num_face_normals > index)) {
+        if (bot.num_face_normals > (index + 1))
+            memmove(bot.face_normals + index * 3, bot.face_normals + index * 3 + 3, (bot.num_face_normals - index - 1) * 3 * sizeof(int));
+
+        if (botIndex == 0)
+            bot.face_normals = static_cast<int*>(bu_realloc(bot.face_normals, (bot.num_face_normals - 1) * 3 * sizeof(int), "bot interface RemoveFace(): face_normals"));
+
+        --bot.num_face_normals;
+    }
+
+    --bot.num_faces;
+}
+
+
+/// checks the flat arrays of SetMesh(), AdoptMesh() and AppendFaces() before the mesh is touched
+static bool MeshIsValid
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    faces,
+    size_t        numberOfFaces,
+    const double* normals,
+    size_t        numberOfNormals,
+    const int*    faceNormals
+) {
+    bool ret = ((vertices != 0) || (numberOfVertices == 0)) &&
+               ((faces != 0) || (numberOfFaces == 0)) &&
+               ((normals == 0) || (faceNormals != 0));
+
+    for (size_t i = 0; ret && (i < 3 * numberOfFaces); ++i) {
+        if ((faces[i] < 0) || (static_cast<size_t>(faces[i]) >= numberOfVertices))
+            ret = false;
+        else if ((normals != 0) && ((faceNormals[i] < 0) || (static_cast<size_t>(faceNormals[i]) >= numberOfNormals)))
+            ret = false;
+    }
+
+    assert(ret);
+
+    return ret;
+}
+
+
+/// appends the faces of flat arrays in one pass
+/** The faces and faceNormals index into the given vertices and normals.
+    With weld the vertices are merged with the existing ones like in BagOfTriangles::AddFace(),
+    otherwise they are appended as they are. */
+static void AppendMesh
+(
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex& index,
+    const double*        vertices,
+    size_t               numberOfVertices,
+    const int*           faces,
+    size_t               numberOfFaces,
+    const double*        normals,
+    size_t               numberOfNormals,
+    const int*           faceNormals,
+    const double*        thickness,
+    bool                 weld
+) {
+    assert((vertices != 0) || (numberOfVertices == 0));
+    assert((faces != 0) || (numberOfFaces == 0));
+    assert((normals == 0) || (faceNormals != 0));
+
+    if (numberOfFaces == 0)
+        return;
+
+    size_t oldNumberOfFaces = bot.num_faces;
+
+    // the face normals of the existing faces have to be complete before appending to them
+    if (oldNumberOfFaces > 0)
+        EnsureFaceNormals(bot, &index);
+
+    // vertices
+    int  vertexOffset = static_cast<int>(bot.num_vertices);
+    int* vertexMap    = 0;
+
+    if (weld) {
+        vertexMap = static_cast<int*>(bu_malloc(numberOfVertices * sizeof(int), "bot interface AppendMesh(): vertexMap"));
+
+        for (size_t i = 0; i < numberOfVertices; ++i) {
+            point_t point = {vertices[3 * i], vertices[3 * i + 1], vertices[3 * i + 2]};
+
+            vertexMap[i] = AddVertex(point, bot, index);
+        }
+    }
+    else if (numberOfVertices > 0) {
+        bot.vertices = static_cast<fastf_t*>(Reserve(bot.vertices, index.verticesCapacity, bot.num_vertices + numberOfVertices, 3 * sizeof(fastf_t), "bot interface AppendMesh(): vertices"));
+
+        for (size_t i = 0; i < 3 * numberOfVertices; ++i)
+            bot.vertices[3 * bot.num_vertices + i] = vertices[i];
+
+        bot.num_vertices += numberOfVertices;
+        InvalidateHash(index);
+        InvalidateVertexUsage(index);
+    }
+
+    // faces
+    bot.faces = static_cast<int*>(Reserve(bot.faces, index.facesCapacity, oldNumberOfFaces + numberOfFaces, 3 * sizeof(int), "bot interface AppendMesh(): faces"));
+
+    for (size_t i = 0; i < 3 * numberOfFaces; ++i) {
+        assert((faces[i] >= 0) && (static_cast<size_t>(faces[i]) < numberOfVertices));
+
+        if (weld) {
+            bot.faces[3 * oldNumberOfFaces + i] = vertexMap[faces[i]];
+            UseVertex(index, vertexMap[faces[i]]);
+        }
+        else
+            bot.faces[3 * oldNumberOfFaces + i] = faces[i] + vertexOffset;
+    }
+
+    if (vertexMap != 0)
+        bu_free(vertexMap, "bot interface AppendMesh(): vertexMap");
+
+    // thickness, new faces without thickness get 1 like in BagOfTriangles::AddFace()
+    if ((thickness != 0) || (bot.thickness != 0)) {
+        if (bot.thickness == 0) {
+            bot.thickness = static_cast<fastf_t*>(bu_calloc(oldNumberOfFaces + numberOfFaces, sizeof(fastf_t), "bot interface AppendMesh(): thickness"));
+            index.thicknessCapacity = oldNumberOfFaces + numberOfFaces;
+        }
+        else
+            bot.thickness = static_cast<fastf_t*>(Reserve(bot.thickness, index.thicknessCapacity, oldNumberOfFaces + numberOfFaces, sizeof(fastf_t), "bot interface AppendMesh(): thickness"));
+
+        for (size_t i = 0; i < numberOfFaces; ++i)
+            bot.thickness[oldNumberOfFaces + i] = (thickness != 0) ? thickness[i] : 1.;
+    }
+
+    // face mode, the new faces take the mode of the last face like in BagOfTriangles::AddFace()
+    if (bot.face_mode != 0) {
+        bu_bitv* temp = bu_bitv_new(oldNumberOfFaces + numberOfFaces);
+
+        for (size_t i = 0; i < oldNumberOfFaces; ++i) {
             if (BU_BITTEST(bot.face_mode, i))
-                BU_BITSET(temp, i - 1);
-            else
-                BU_BITCLR(temp, i - 1);
+                BU_BITSET(temp, i);
+        }
+
+        if ((oldNumberOfFaces > 0) && BU_BITTEST(bot.face_mode, oldNumberOfFaces - 1)) {
+            for (size_t i = oldNumberOfFaces; i < (oldNumberOfFaces + numberOfFaces); ++i)
+                BU_BITSET(temp, i);
         }
 
         bu_bitv_free(bot.face_mode);
         bot.face_mode = temp;
     }
 
-    if ((bot.face_normals != 0) && (bot.num_face_normals > index)) {
-        if (bot.num_face_normals > (index + 1))
-            memcpy(bot.face_normals + index * 3, bot.face_normals + index * 3 + 3, (bot.num_face_normals - index - 1) * 3 * sizeof(int));
+    // normals
+    bot.face_normals = static_cast<int*>(Reserve(bot.face_normals, index.faceNormalsCapacity, oldNumberOfFaces + numberOfFaces, 3 * sizeof(int), "bot interface AppendMesh(): face_normals"));
 
-        bot.face_normals = static_cast<int*>(bu_realloc(bot.face_normals, (bot.num_face_normals - 1) * 3 * sizeof(int), "bot interface RemoveFace(): face_normals"));
+    if (normals != 0) {
+        int normalOffset = static_cast<int>(bot.num_normals);
+
+        bot.normals = static_cast<fastf_t*>(bu_realloc(bot.normals, (bot.num_normals + numberOfNormals) * 3 * sizeof(fastf_t), "bot interface AppendMesh(): normals"));
+
+        for (size_t i = 0; i < 3 * numberOfNormals; ++i)
+            bot.normals[3 * bot.num_normals + i] = normals[i];
+
+        bot.num_normals += numberOfNormals;
+
+        for (size_t i = 0; i < 3 * numberOfFaces; ++i) {
+            assert((faceNormals[i] >= 0) && (static_cast<size_t>(faceNormals[i]) < numberOfNormals));
+
+            bot.face_normals[3 * oldNumberOfFaces + i] = faceNormals[i] + normalOffset;
+        }
     }
+    else {
+        fastf_t defaultNormal[3] = {0};
+        int     normalIndex      = AddNormal(defaultNormal, bot);
 
-    --bot.num_faces;
+        for (size_t i = 0; i < 3 * numberOfFaces; ++i)
+            bot.face_normals[3 * oldNumberOfFaces + i] = normalIndex;
+    }
+
+    bot.num_faces        = oldNumberOfFaces + numberOfFaces;
+    bot.num_face_normals = bot.num_faces;
+}
+
+
+static void ReplaceMesh
+(
+    rt_bot_internal&     bot,
+    BagOfTrianglesIndex& index,
+    const double*        vertices,
+    size_t               numberOfVertices,
+    const int*           faces,
+    size_t               numberOfFaces,
+    const double*        normals,
+    size_t               numberOfNormals,
+    const int*           faceNormals,
+    const double*        thickness
+) {
+    bool hasFaceMode  = (bot.face_mode != 0);
+    bool hasThickness = (bot.thickness != 0);
+
+    CleanBotInternal(&bot);
+    ResetIndex(index, bot);
+    AppendMesh(bot, index, vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals, thickness, false);
+
+    if (hasThickness && (bot.thickness == 0) && (bot.num_faces > 0)) {
+        bot.thickness           = static_cast<fastf_t*>(bu_malloc(bot.num_faces * sizeof(fastf_t), "bot interface ReplaceMesh(): thickness"));
+        index.thicknessCapacity = bot.num_faces;
+
+        for (size_t i = 0; i < bot.num_faces; ++i)
+            bot.thickness[i] = 1.;
+    }
+
+    // a new face mode without any bit set
+    if (hasFaceMode)
+        bot.face_mode = bu_bitv_new(bot.num_faces);
 }
 
 
 BagOfTriangles::BagOfTriangles
 (
     void
-) : Object() {
+) : Object(), m_index(0) {
     if (!BU_SETJUMP) {
         BU_GET(m_internalp, rt_bot_internal);
         m_internalp->magic = RT_BOT_INTERNAL_MAGIC;
@@ -511,7 +1013,7 @@ BagOfTriangles::BagOfTriangles
 BagOfTriangles::BagOfTriangles
 (
     const BagOfTriangles& original
-) {
+) : m_index(0) {
     if (!BU_SETJUMP)
         m_internalp = CloneBotInternal(*original.Internal());
     else {
@@ -528,6 +1030,12 @@ BagOfTriangles::~BagOfTriangles
 ) {
     if (m_internalp != 0)
         FreeBotInternal(m_internalp);
+
+    if (m_index != 0) {
+        InvalidateHash(*m_index);
+        InvalidateVertexUsage(*m_index);
+        bu_free(m_index, "BRLCAD::BagOfTriangles::~BagOfTriangles::m_index");
+    }
 }
 
 
@@ -543,6 +1051,9 @@ const BagOfTriangles& BagOfTriangles::operator=
             const rt_bot_internal* originalInternal = original.Internal();
 
             CopyBotInternal(thisInternal, originalInternal);
+
+            if (m_index != 0)
+                ResetIndex(*m_index, *thisInternal);
         }
         else
             BU_UNSETJUMP;
@@ -584,7 +1095,7 @@ void BagOfTriangles::Face::SetPoint
     if ((m_bot != 0) && (index < 3)) {
         point_t newPoint = {point.coordinates[0], point.coordinates[1], point.coordinates[2]};
 
-        m_bot->faces[m_faceIndex * 3 + index] = SwapVertex(m_bot->faces[m_faceIndex * 3 + index], newPoint, *m_bot);
+        m_bot->faces[m_faceIndex * 3 + index] = SwapVertex(m_bot->faces[m_faceIndex * 3 + index], newPoint, *m_bot, *m_index);
     }
 }
 
@@ -630,9 +1141,13 @@ void BagOfTriangles::Face::SetThickness
     assert(m_bot->mode != RT_BOT_SURFACE);
 
     if (m_bot != 0) {
-        if (m_bot->thickness == 0)
+        if (m_bot->thickness == 0) {
             m_bot->thickness = static_cast<fastf_t*>(bu_calloc(m_bot->num_faces, sizeof(fastf_t), "BRLAD::BagOfTriangles::Face::SetThickness(): thickness"));
 
+            if (m_index != 0)
+                m_index->thicknessCapacity = m_bot->num_faces;
+        }
+
         m_bot->thickness[m_faceIndex] = value;
     }
 }
@@ -697,7 +1212,7 @@ void BagOfTriangles::Face::SetNormal
     assert(m_bot != 0);
 
     if ((m_bot != 0) && (index < 3)) {
-        EnsureFaceNormals(*m_bot);
+        EnsureFaceNormals(*m_bot, m_index);
 
         point_t newNormal = {normal.coordinates[0], normal.coordinates[1], normal.coordinates[2]};
 
@@ -866,7 +1381,7 @@ BagOfTriangles::Face BagOfTriangles::GetFace
     Face ret;
 
     if (index < Internal()->num_faces)
-        ret = Face(Internal(), index);
+        ret = Face(Internal(), index, &Index());
 
     return ret;
 }
@@ -881,20 +1396,24 @@ BagOfTriangles::Face BagOfTriangles::AddFace
     BagOfTriangles::Face ret;
 
     if (!BU_SETJUMP) {
-        rt_bot_internal* bot = Internal();
+        rt_bot_internal*     bot   = Internal();
+        BagOfTrianglesIndex& index = Index();
 
-        bot->faces = static_cast<int*>(bu_realloc(bot->faces, (bot->num_faces + 1) * 3 * sizeof(int), "BagOfTriangles::AddFace(): faces"));
+        bot->faces = static_cast<int*>(Reserve(bot->faces, index.facesCapacity, bot->num_faces + 1, 3 * sizeof(int), "BagOfTriangles::AddFace(): faces"));
 
         point_t newPoint1 = {point1.coordinates[0], point1.coordinates[1], point1.coordinates[2]};
         point_t newPoint2 = {point2.coordinates[0], point2.coordinates[1], point2.coordinates[2]};
         point_t newPoint3 = {point3.coordinates[0], point3.coordinates[1], point3.coordinates[2]};
 
-        bot->faces[bot->num_faces * 3]     = AddVertex(newPoint1, *bot);
-        bot->faces[bot->num_faces * 3 + 1] = AddVertex(newPoint2, *bot);
-        bot->faces[bot->num_faces * 3 + 2] = AddVertex(newPoint3, *bot);
+        bot->faces[bot->num_faces * 3]     = AddVertex(newPoint1, *bot, index);
+        bot->faces[bot->num_faces * 3 + 1] = AddVertex(newPoint2, *bot, index);
+        bot->faces[bot->num_faces * 3 + 2] = AddVertex(newPoint3, *bot, index);
+
+        for (int i = 0; i < 3; ++i)
+            UseVertex(index, bot->faces[bot->num_faces * 3 + i]);
 
         if(Internal()->thickness != 0) {
-            bot->thickness                 = static_cast<fastf_t*>(bu_realloc(bot->thickness, (bot->num_faces + 1) * sizeof(fastf_t), "BagOfTriangles::InsertFace: thickness"));
+            bot->thickness                 = static_cast<fastf_t*>(Reserve(bot->thickness, index.thicknessCapacity, bot->num_faces + 1, sizeof(fastf_t), "BagOfTriangles::InsertFace: thickness"));
             bot->thickness[bot->num_faces] = 1.;
         }
 
@@ -923,9 +1442,9 @@ BagOfTriangles::Face BagOfTriangles::AddFace
         }
 
         ++bot->num_faces;
-        EnsureFaceNormals(*bot);
+        EnsureFaceNormals(*bot, &index);
 
-        ret = Face(bot, bot->num_faces - 1);
+        ret = Face(bot, bot->num_faces - 1, &index);
     }
     else
         BU_UNSETJUMP;
@@ -942,11 +1461,195 @@ void BagOfTriangles::DeleteFace(
     assert(index < Internal()->num_faces);
 
     if (!BU_SETJUMP) {
-        for(int i = 0; i < 3; i++)
-            RemoveVertex(Internal()->faces[index * 3 + i], *Internal());
+        rt_bot_internal*     bot      = Internal();
+        BagOfTrianglesIndex& botIndex = Index();
+
+        if (!botIndex.usageValid)
+            BuildVertexUsage(botIndex, *bot);
+
+        // the unused vertices remain until the next compaction
+        for (int i = 0; i < 3; ++i)
+            ReleaseVertex(botIndex, bot->faces[index * 3 + i]);
+
+        RemoveFace(index, *bot, &botIndex);
 
-        RemoveFace(index, *Internal());
+        if (botIndex.numberOfUnusedVertices > (bot->num_vertices / 2))
+            CompactVertices(*bot, &botIndex);
     }
+
+    BU_UNSETJUMP;
+}
+
+
+void BagOfTriangles::Compact(void) {
+    if (!BU_SETJUMP) {
+        rt_bot_internal*     bot      = Internal();
+        BagOfTrianglesIndex& botIndex = Index();
+
+        CompactVertices(*bot);
+
+        // shrink the arrays to their sizes
+        if (bot->num_vertices > 0)
+            bot->vertices = static_cast<fastf_t*>(bu_realloc(bot->vertices, bot->num_vertices * 3 * sizeof(fastf_t), "BRLCAD::BagOfTriangles::Compact(): vertices"));
+
+        if (bot->num_faces > 0) {
+            bot->faces = static_cast<int*>(bu_realloc(bot->faces, bot->num_faces * 3 * sizeof(int), "BRLCAD::BagOfTriangles::Compact(): faces"));
+
+            if (bot->thickness != 0)
+                bot->thickness = static_cast<fastf_t*>(bu_realloc(bot->thickness, bot->num_faces * sizeof(fastf_t), "BRLCAD::BagOfTriangles::Compact(): thickness"));
+        }
+
+        if ((bot->face_normals != 0) && (bot->num_face_normals > 0))
+            bot->face_normals = static_cast<int*>(bu_realloc(bot->face_normals, bot->num_face_normals * 3 * sizeof(int), "BRLCAD::BagOfTriangles::Compact(): face_normals"));
+
+        if (bot->face_mode != 0) {
+            bu_bitv* temp = bu_bitv_new(bot->num_faces);
+
+            for (size_t i = 0; i < bot->num_faces; ++i) {
+                if (BU_BITTEST(bot->face_mode, i))
+                    BU_BITSET(temp, i);
+            }
+
+            bu_bitv_free(bot->face_mode);
+            bot->face_mode = temp;
+        }
+
+        ResetIndex(botIndex, *bot);
+    }
+
+    BU_UNSETJUMP;
+}
+
+
+void BagOfTriangles::SetMesh
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    faces,
+    size_t        numberOfFaces,
+    const double* normals,
+    size_t        numberOfNormals,
+    const int*    faceNormals,
+    const double* thickness
+) {
+    if (!MeshIsValid(vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals))
+        return;
+
+    if (!BU_SETJUMP)
+        ReplaceMesh(*Internal(), Index(), vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals, thickness);
+
+    BU_UNSETJUMP;
+}
+
+
+void BagOfTriangles::AdoptMesh
+(
+    double* vertices,
+    size_t  numberOfVertices,
+    int*    faces,
+    size_t  numberOfFaces,
+    double* normals,
+    size_t  numberOfNormals,
+    int*    faceNormals,
+    double* thickness
+) {
+    // normals without face normals or indices out of range would give an inconsistent mesh
+    if (!MeshIsValid(vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals))
+        return;
+
+    if (!BU_SETJUMP) {
+        rt_bot_internal*     bot   = Internal();
+        BagOfTrianglesIndex& index = Index();
+
+        if (sizeof(fastf_t) != sizeof(double)) {
+            // the arrays can't be used directly
+            ReplaceMesh(*bot, index, vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals, thickness);
+
+            bu_free(vertices, "BRLCAD::BagOfTriangles::AdoptMesh(): vertices");
+            bu_free(faces, "BRLCAD::BagOfTriangles::AdoptMesh(): faces");
+
+            if (normals != 0)
+                bu_free(normals, "BRLCAD::BagOfTriangles::AdoptMesh(): normals");
+
+            if (faceNormals != 0)
+                bu_free(faceNormals, "BRLCAD::BagOfTriangles::AdoptMesh(): faceNormals");
+
+            if (thickness != 0)
+                bu_free(thickness, "BRLCAD::BagOfTriangles::AdoptMesh(): thickness");
+        }
+        else {
+            bool hasFaceMode  = (bot->face_mode != 0);
+            bool hasThickness = (bot->thickness != 0);
+
+            CleanBotInternal(bot);
+
+            bot->vertices     = reinterpret_cast<fastf_t*>(vertices);
+            bot->num_vertices = numberOfVertices;
+            bot->faces        = faces;
+            bot->num_faces    = numberOfFaces;
+
+            if (thickness != 0)
+                bot->thickness = reinterpret_cast<fastf_t*>(thickness);
+            else if (hasThickness && (numberOfFaces > 0)) {
+                bot->thickness = static_cast<fastf_t*>(bu_malloc(numberOfFaces * sizeof(fastf_t), "BRLCAD::BagOfTriangles::AdoptMesh(): thickness"));
+
+                for (size_t i = 0; i < numberOfFaces; ++i)
+                    bot->thickness[i] = 1.;
+            }
+
+            if (hasFaceMode)
+                bot->face_mode = bu_bitv_new(numberOfFaces);
+
+            if (normals != 0) {
+                bot->normals          = reinterpret_cast<fastf_t*>(normals);
+                bot->num_normals      = numberOfNormals;
+                bot->face_normals     = faceNormals;
+                bot->num_face_normals = numberOfFaces;
+            }
+            else {
+                if (faceNormals != 0)
+                    bu_free(faceNormals, "BRLCAD::BagOfTriangles::AdoptMesh(): faceNormals");
+
+                // all faces reference a zero normal like in SetMesh()
+                if (numberOfFaces > 0) {
+                    fastf_t defaultNormal[3] = {0};
+                    int     normalIndex      = AddNormal(defaultNormal, *bot);
+
+                    bot->face_normals = static_cast<int*>(bu_malloc(3 * numberOfFaces * sizeof(int), "BRLCAD::BagOfTriangles::AdoptMesh(): face_normals"));
+
+                    for (size_t i = 0; i < 3 * numberOfFaces; ++i)
+                        bot->face_normals[i] = normalIndex;
+
+                    bot->num_face_normals = numberOfFaces;
+                }
+            }
+
+            ResetIndex(index, *bot);
+        }
+    }
+
+    BU_UNSETJUMP;
+}
+
+
+void BagOfTriangles::AppendFaces
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    faces,
+    size_t        numberOfFaces,
+    const double* normals,
+    size_t        numberOfNormals,
+    const int*    faceNormals,
+    const double* thickness
+) {
+    if (!MeshIsValid(vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals))
+        return;
+
+    if (!BU_SETJUMP)
+        AppendMesh(*Internal(), Index(), vertices, numberOfVertices, faces, numberOfFaces, normals, numberOfNormals, faceNormals, thickness, true);
+
+    BU_UNSETJUMP;
 }
 
 
@@ -990,7 +1693,7 @@ BagOfTriangles::BagOfTriangles
     directory*      pDir,
     rt_db_internal* ip,
     db_i*           dbip
-) : Object(resp, pDir, ip, dbip), m_internalp(0) {}
+) : Object(resp, pDir, ip, dbip), m_internalp(0), m_index(0) {}
 
 
 
@@ -1020,3 +1723,14 @@ const rt_bot_internal* BagOfTriangles::Internal(void) const {
 
     return ret;
 }
+
+
+BagOfTrianglesIndex& BagOfTriangles::Index(void) {
+    if (m_index == 0) {
+        m_index = static_cast<BagOfTrianglesIndex*>(bu_calloc(1, sizeof(BagOfTrianglesIndex), "BRLCAD::BagOfTriangles::Index::m_index"));
+
+        ResetIndex(*m_index, *Internal());
+    }
+
+    return *m_index;
+}
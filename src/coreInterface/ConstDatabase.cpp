@@ -33,6 +33,7 @@
 
 #include "raytrace.h"
 #include "bu/parallel.h"
+#include "bu/time.h"
 
 #include <brlcad/Torus.h>
 #include <brlcad/Cone.h>
@@ -93,7 +94,8 @@ static void InitBrlCad(void) {
 // class ConstDatabase
 //
 
-ConstDatabase::ConstDatabase(void) : m_rtip(0), m_resp(0) {
+ConstDatabase::ConstDatabase(void) : m_rtip(0), m_resp(0), m_resources(0), m_numberOfResources(0), m_selectTime(0.), m_prepTime(0.),
+                                     m_selectedObjects(0), m_selectedObjectHidden(0), m_numberOfSelectedObjects(0), m_plotCache(0) {
     InitBrlCad();
 
     if (rt_uniresource.re_magic != RESOURCE_MAGIC)
@@ -102,6 +104,11 @@ ConstDatabase::ConstDatabase(void) : m_rtip(0), m_resp(0) {
     if (!BU_SETJUMP) {
         m_resp = static_cast<resource*>(bu_calloc(1, sizeof(resource), "BRLCAD::ConstDatabase::~ConstDatabase::m_resp"));
         rt_init_resource(m_resp, 0, NULL);
+
+        // the slot table has a fixed size to keep it valid while other threads are reading it
+        m_resources         = static_cast<resource**>(bu_calloc(MAX_PSW, sizeof(resource*), "BRLCAD::ConstDatabase::ConstDatabase::m_resources"));
+        m_resources[0]      = m_resp;
+        m_numberOfResources = 1;
     }
     else {
         BU_UNSETJUMP;
@@ -119,6 +126,26 @@ ConstDatabase::~ConstDatabase(void) {
         BU_UNSETJUMP;
     }
 
+    ClearSelectionList();
+
+    if (m_plotCache != 0) {
+        InvalidatePlotCache(0);
+
+        if (m_plotCache->entries != 0)
+            bu_free(m_plotCache->entries, "BRLCAD::ConstDatabase::~ConstDatabase::m_plotCache->entries");
+
+        bu_free(m_plotCache, "BRLCAD::ConstDatabase::~ConstDatabase::m_plotCache");
+    }
+
+    if (m_resources != 0) {
+        for (size_t i = 1; i < m_numberOfResources; ++i) {
+            rt_clean_resource_complete(0, m_resources[i]);
+            bu_free(m_resources[i], "BRLCAD::ConstDatabase::~ConstDatabase::m_resources[i]");
+        }
+
+        bu_free(m_resources, "BRLCAD::ConstDatabase::~ConstDatabase::m_resources");
+    }
+
     if (m_resp != 0) {
         rt_clean_resource_complete(0, m_resp);
         bu_free(m_resp, "BRLCAD::ConstDatabase::~ConstDatabase::m_resp");
@@ -147,7 +174,7 @@ bool ConstDatabase::Load
 
         if (m_rtip != 0) {
             if (!BU_SETJUMP)
-                rt_init_resource(m_resp, 0, m_rtip);
+                InitResources();
             else {
                 BU_UNSETJUMP;
 
@@ -257,6 +284,72 @@ ConstDatabase::TopObjectIterator ConstDatabase::FirstTopObject(void) const {
 }
 
 
+template<class T>
+void ConstDatabase::CallWithObject
+(
+    resource*       resp,
+    directory*      pDir,
+    rt_db_internal* ip,
+    db_i*           dbip,
+    ObjectCallback& callback
+) {
+    callback(T(resp, pDir, ip, dbip));
+}
+
+
+void ConstDatabase::HandOverObject
+(
+    directory*      pDir,
+    rt_db_internal& intern,
+    int             id,
+    ObjectCallback& callback
+) const {
+    typedef void (*ObjectFactory)(resource*, directory*, rt_db_internal*, db_i*, ObjectCallback&);
+
+    // the wrappers indexed by their librt type ID, 0 means Unknown
+    static const ObjectFactory ObjectTypes[] = {
+        0,                                          //  0 ID_NULL
+        CallWithObject<Torus>,                      //  1 ID_TOR
+        CallWithObject<Cone>,                       //  2 ID_TGC
+        CallWithObject<Ellipsoid>,                  //  3 ID_ELL
+        CallWithObject<Arb8>,                       //  4 ID_ARB8
+        0,                                          //  5 ID_ARS
+        CallWithObject<Halfspace>,                  //  6 ID_HALF
+        0,                                          //  7 ID_REC
+        0,                                          //  8 ID_POLY
+        0,                                          //  9 ID_BSPLINE
+        CallWithObject<Sphere>,                     // 10 ID_SPH
+        CallWithObject<NonManifoldGeometry>,        // 11 ID_NMG
+        0,                                          // 12 ID_EBM
+        0,                                          // 13 ID_VOL
+        0,                                          // 14 ID_ARBN
+        CallWithObject<Pipe>,                       // 15 ID_PIPE
+        CallWithObject<Particle>,                   // 16 ID_PARTICLE
+        CallWithObject<ParabolicCylinder>,          // 17 ID_RPC
+        CallWithObject<HyperbolicCylinder>,         // 18 ID_RHC
+        CallWithObject<Paraboloid>,                 // 19 ID_EPA
+        CallWithObject<Hyperboloid>,                // 20 ID_EHY
+        CallWithObject<EllipticalTorus>,            // 21 ID_ETO
+        0,                                          // 22 ID_GRIP
+        0,                                          // 23 ID_JOINT
+        0,                                          // 24 ID_HF
+        0,                                          // 25 ID_DSP
+        CallWithObject<Sketch>,                     // 26 ID_SKETCH
+        0,                                          // 27 ID_EXTRUDE
+        0,                                          // 28 ID_SUBMODEL
+        0,                                          // 29 ID_CLINE
+        CallWithObject<BagOfTriangles>,             // 30 ID_BOT
+        CallWithObject<Combination>                 // 31 ID_COMBINATION
+    };
+    static const int NumberOfObjectTypes = sizeof(ObjectTypes) / sizeof(ObjectTypes[0]);
+
+    if ((id > ID_NULL) && (id < NumberOfObjectTypes) && (ObjectTypes[id] != 0))
+        ObjectTypes[id](m_resp, pDir, &intern, m_rtip->rti_dbip, callback);
+    else
+        callback(Unknown(m_resp, pDir, &intern, m_rtip->rti_dbip));
+}
+
+
 void ConstDatabase::Get
 (
     const char*     objectName,
@@ -272,78 +365,7 @@ void ConstDatabase::Get
                     int            id = rt_db_get_internal(&intern, pDir, m_rtip->rti_dbip, 0, m_resp);
 
                     try {
-                        switch(id) {
-                        case ID_TOR: // 1
-                            callback(Torus(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_TGC: // 2
-                            callback(Cone(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_ELL: // 3
-                            callback(Ellipsoid(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_ARB8: // 4
-                            callback(Arb8(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_HALF: // 6
-                            callback(Halfspace(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_SPH: // 10
-                            callback(Sphere(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_NMG: // 11
-                            callback(NonManifoldGeometry(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_PIPE: // 15
-                            callback(Pipe(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_PARTICLE: // 16
-                            callback(Particle(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_RPC: // 17
-                            callback(ParabolicCylinder(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_RHC: // 18
-                            callback(HyperbolicCylinder(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_EPA: // 19
-                            callback(Paraboloid(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_EHY: // 20
-                            callback(Hyperboloid(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_ETO: // 21
-                            callback(EllipticalTorus(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_SKETCH: // 26
-                            callback(Sketch(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_BOT: // 30
-                            callback(BagOfTriangles(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        case ID_COMBINATION: // 31
-                            callback(Combination(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                            break;
-
-                        default:
-                            callback(Unknown(m_resp, pDir, &intern, m_rtip->rti_dbip));
-                        }
+                        HandOverObject(pDir, intern, id, callback);
                     }
                     catch(...) {
                         BU_UNSETJUMP;
@@ -392,6 +414,25 @@ Object* ConstDatabase::Get
 }
 
 
+static int GetThreads
+(
+    unsigned int numberOfThreads
+) {
+    int ret = static_cast<int>(numberOfThreads);
+
+    if (ret == 0)
+        ret = bu_avail_cpus();
+
+    if (ret > MAX_PSW)
+        ret = MAX_PSW;
+
+    if (ret < 1)
+        ret = 1;
+
+    return ret;
+}
+
+
 static tree* FacetizeRegionEnd
 (
     db_tree_state*      tsp,
@@ -487,253 +528,1537 @@ NonManifoldGeometry* ConstDatabase::Facetize
 }
 
 
-static tree* PlotLeaf
+struct RegionPathList {
+    char** paths;
+    size_t numberOfPaths;
+    size_t capacity;
+};
+
+
+static void AppendRegionPath
 (
-    db_tree_state*      tsp,
-    const db_full_path* pathp,
-    rt_db_internal*     ip,
-    void*               clientData
+    RegionPathList* regionList,
+    const db_full_path* pathp
 ) {
-    tree*    ret   = TREE_NULL;
-    bu_list* vlist = static_cast<bu_list*>(clientData);
+    if (regionList->numberOfPaths == regionList->capacity) {
+        size_t newCapacity = (regionList->capacity > 0) ? 2 * regionList->capacity : 16;
 
-    if (ip->idb_meth->ft_plot != 0) {
-        if (ip->idb_meth->ft_plot(vlist, ip, tsp->ts_ttol, tsp->ts_tol, 0) == 0) {
-            // Indicate success by returning something other than TREE_NULL
-            BU_GET(ret, tree);
-            RT_TREE_INIT(ret);
-            ret->tr_op = OP_NOP;
-        }
+        regionList->paths    = static_cast<char**>(bu_realloc(regionList->paths, newCapacity * sizeof(char*), "BRLCAD::ConstDatabase::AppendRegionPath::paths"));
+        regionList->capacity = newCapacity;
     }
 
-    return ret;
+    regionList->paths[regionList->numberOfPaths] = db_path_to_string(pathp);
+    ++regionList->numberOfPaths;
 }
 
 
-void ConstDatabase::Plot
+/// records the region and skips its subtree
+static int CollectRegionStart
 (
-    const char* objectName,
-    VectorList& vectorList
-) const {
-    if (m_rtip != 0) {
-        if (!BU_SETJUMP) {
-            db_tree_state initState;
+    db_tree_state*          UNUSED(tsp),
+    const db_full_path*     pathp,
+    const rt_comb_internal* UNUSED(combination),
+    void*                   clientData
+) {
+    AppendRegionPath(static_cast<RegionPathList*>(clientData), pathp);
 
-            db_init_db_tree_state(&initState, m_rtip->rti_dbip, m_resp);
-            initState.ts_ttol = &m_rtip->rti_ttol;
-            initState.ts_tol  = &m_rtip->rti_tol;
+    return -1;
+}
 
-            db_walk_tree(m_rtip->rti_dbip,
-                         1,
-                         &objectName,
-                         1,
-                         &initState,
-                         0,
-                         0,
-                         PlotLeaf,
-                         vectorList.m_vlist);
-        }
-        else
-            BU_UNSETJUMP;
 
-        BU_UNSETJUMP;
-    }
+/// records a solid which is not part of a region
+static tree* CollectRegionEnd
+(
+    db_tree_state*      tsp,
+    const db_full_path* pathp,
+    tree*               curtree,
+    void*               clientData
+) {
+    AppendRegionPath(static_cast<RegionPathList*>(clientData), pathp);
+
+    if (curtree != TREE_NULL)
+        db_free_tree(curtree, tsp->ts_resp);
+
+    return TREE_NULL;
 }
 
 
-void ConstDatabase::Select
+static tree* CollectLeaf
 (
-    const char* objectName
+    db_tree_state*      UNUSED(tsp),
+    const db_full_path* UNUSED(pathp),
+    rt_db_internal*     UNUSED(ip),
+    void*               UNUSED(clientData)
 ) {
-    if (m_rtip != 0) {
-        if (!BU_SETJUMP)
-            rt_gettree(m_rtip, objectName);
+    tree* ret;
 
-        BU_UNSETJUMP;
-    }
-}
+    BU_GET(ret, tree);
+    RT_TREE_INIT(ret);
+    ret->tr_op = OP_NOP;
 
+    return ret;
+}
 
-void ConstDatabase::UnSelectAll(void) {
-    if (m_rtip != 0) {
-        if (!BU_SETJUMP)
-            rt_clean(m_rtip);
 
-        BU_UNSETJUMP;
-    }
+/// collects the regions of \a objectName in tree walk order with a walk which doesn't load their solids
+static void CollectRegionPaths
+(
+    rt_i*           rtip,
+    resource*       resp,
+    const char*     objectName,
+    RegionPathList& regionList
+) {
+    db_tree_state initState;
+
+    db_init_db_tree_state(&initState, rtip->rti_dbip, resp);
+    initState.ts_ttol = &rtip->rti_ttol;
+    initState.ts_tol  = &rtip->rti_tol;
+
+    db_walk_tree(rtip->rti_dbip,
+                 1,
+                 &objectName,
+                 1,
+                 &initState,
+                 CollectRegionStart,
+                 CollectRegionEnd,
+                 CollectLeaf,
+                 &regionList);
 }
 
 
-bool ConstDatabase::SelectionIsEmpty(void) const {
-    bool ret = true;
+static void FreeRegionPaths
+(
+    RegionPathList& regionList
+) {
+    for (size_t i = 0; i < regionList.numberOfPaths; ++i)
+        bu_free(regionList.paths[i], "BRLCAD::ConstDatabase::FreeRegionPaths::paths[i]");
 
-    if (m_rtip != 0)
-        ret = m_rtip->nsolids < 1;
+    if (regionList.paths != 0)
+        bu_free(regionList.paths, "BRLCAD::ConstDatabase::FreeRegionPaths::paths");
+
+    regionList.paths         = 0;
+    regionList.numberOfPaths = 0;
+    regionList.capacity      = 0;
+}
+
+
+/// tessellates and evaluates a single region into \a regionModel, the result is the region of the returned tree
+static tree* EvaluateRegion
+(
+    rt_i*       rtip,
+    resource*   resp,
+    bu_list*    vlfree,
+    const char* regionPath,
+    model*&     regionModel
+) {
+    tree*         ret = 0;
+    db_tree_state initState;
+
+    db_init_db_tree_state(&initState, rtip->rti_dbip, resp);
+    initState.ts_ttol = &rtip->rti_ttol;
+    initState.ts_tol  = &rtip->rti_tol;
+    initState.ts_m    = &regionModel;
+
+    if (db_walk_tree(rtip->rti_dbip,
+                     1,
+                     &regionPath,
+                     1,
+                     &initState,
+                     0,
+                     FacetizeRegionEnd,
+                     nmg_booltree_leaf_tess,
+                     &ret) == 0) {
+        if (ret != 0)
+            nmg_boolean(ret, regionModel, vlfree, &rtip->rti_tol, resp);
+    }
 
     return ret;
 }
 
 
-Vector3D ConstDatabase::BoundingBoxMinima(void) const {
-    Vector3D ret;
+/// tessellates and evaluates a single region into a model of its own
+static model* FacetizeRegion
+(
+    rt_i*       rtip,
+    resource*   resp,
+    bu_list*    vlfree,
+    const char* regionPath
+) {
+    model* ret = 0;
 
-    if (!SelectionIsEmpty()) {
-        if (!BU_SETJUMP) {
-            if (m_rtip->needprep)
-                rt_prep(m_rtip);
+    if (!BU_SETJUMP) {
+        model* regionModel = nmg_mm();
+        tree*  regionTree  = EvaluateRegion(rtip, resp, vlfree, regionPath, regionModel);
 
-            VMOVE(ret.coordinates, m_rtip->mdl_min);
+        if (regionTree != 0) {
+            // the same mess as in ConstDatabase::Facetize(const char*): the tree owns the evaluated model
+            ret = nmg_clone_model(regionModel);
+
+            db_free_tree(regionTree, resp);
         }
 
+        nmg_km(regionModel);
+    }
+    else {
         BU_UNSETJUMP;
     }
 
+    BU_UNSETJUMP;
+
     return ret;
 }
 
 
-Vector3D ConstDatabase::BoundingBoxMaxima(void) const {
-    Vector3D ret;
+/// tessellates, evaluates and triangulates a single region, the non-manifold geometry is released immediately
+static rt_bot_internal* TriangulateRegion
+(
+    rt_i*       rtip,
+    resource*   resp,
+    bu_list*    vlfree,
+    const char* regionPath
+) {
+    rt_bot_internal* ret = 0;
 
-    if (!SelectionIsEmpty()) {
-        if (!BU_SETJUMP) {
-            if (m_rtip->needprep)
-                rt_prep(m_rtip);
+    if (!BU_SETJUMP) {
+        model* regionModel = nmg_mm();
+        tree*  regionTree  = EvaluateRegion(rtip, resp, vlfree, regionPath, regionModel);
 
-            VMOVE(ret.coordinates, m_rtip->mdl_max);
+        if (regionTree != 0) {
+            // the model is converted before the tree is freed, no clone needed
+            if (BU_LIST_NON_EMPTY(&regionModel->r_hd))
+                ret = nmg_mdl_to_bot(regionModel, vlfree, &rtip->rti_tol);
+
+            db_free_tree(regionTree, resp);
         }
 
+        nmg_km(regionModel);
+    }
+    else {
         BU_UNSETJUMP;
     }
 
+    BU_UNSETJUMP;
+
     return ret;
 }
 
 
-class ConstDatabaseHit : public ConstDatabase::Hit {
-public:
-    ConstDatabaseHit(application* ap,
-                     partition*   part,
-                     region*      reg) : ConstDatabase::Hit(),
-                                                  m_application(ap),
-                                                  m_partition(part),
-                                                  m_region(reg),
-                                                  m_inVectorsComputed(false),
-                                                  m_outVectorsComputed(false) {
-        assert(m_application != 0);
-        assert(m_partition != 0);
-        assert(m_region != 0);
-   }
+static void FreeBot
+(
+    rt_bot_internal* bot
+) {
+    rt_db_internal intern;
 
-    virtual const char* Name(void) const {
-        return m_region->reg_name;
-    }
+    RT_DB_INTERNAL_INIT(&intern);
+    intern.idb_major_type = DB5_MAJORTYPE_BRLCAD;
+    intern.idb_type       = ID_BOT;
+    intern.idb_meth       = &OBJ[ID_BOT];
+    intern.idb_ptr        = bot;
 
-    virtual double      DistanceIn(void) const {
-        return m_partition->pt_inhit->hit_dist;
-    }
+    rt_db_free_internal(&intern);
+}
 
-    virtual double      DistanceOut(void) const {
-        return m_partition->pt_outhit->hit_dist;
-    }
 
-    virtual Vector3D    PointIn(void) const {
-        ComputeInVectors();
-        return m_partition->pt_inhit->hit_point;
-    }
+struct FacetizeData {
+    rt_i*             rtip;
+    resource**        resources;
+    char**            regionPaths;
+    size_t            numberOfRegions;
+    model*            resultModel;        ///< either this one
+    BagOfTriangles*   resultTriangles;    ///< or this one is set
+    model**           regionModels;
+    rt_bot_internal** regionBots;
+    bool*             regionFinished;
+    int               semaphore;
+    size_t            nextSlot;
+    size_t            nextRegion;
+    size_t            nextMerge;          ///< the first region which isn't merged into the result yet
+};
 
-    virtual Vector3D    PointOut(void) const {
-        ComputeOutVectors();
-        return m_partition->pt_outhit->hit_point;
-    }
 
-    virtual Vector3D    SurfaceNormalIn(void) const {
-        ComputeInVectors();
-        return m_partition->pt_inhit->hit_normal;
-    }
+/// moves the finished regions into the result in tree walk order, has to be called with the semaphore acquired
+static void MergeFinishedRegions
+(
+    FacetizeData* facetizeData
+) {
+    if (!BU_SETJUMP) {
+        while ((facetizeData->nextMerge < facetizeData->numberOfRegions) && facetizeData->regionFinished[facetizeData->nextMerge]) {
+            size_t regionIndex = facetizeData->nextMerge;
 
-    virtual Vector3D    SurfaceNormalOut(void) const {
-        ComputeOutVectors();
-        return m_partition->pt_outhit->hit_normal;
-    }
+            if (facetizeData->regionModels[regionIndex] != 0) {
+                model* regionModel = facetizeData->regionModels[regionIndex];
 
-    virtual Curvature3D SurfaceCurvatureIn(void) const {
-        ComputeInVectors();
+                facetizeData->regionModels[regionIndex] = 0;
+                nmg_merge_models(facetizeData->resultModel, regionModel);
+            }
 
-        curvature curv;
-        RT_CURVATURE(&curv, m_partition->pt_inhit, m_partition->pt_inflip, m_partition->pt_inseg->seg_stp);
+            if (facetizeData->regionBots[regionIndex] != 0) {
+                rt_bot_internal* regionBot = facetizeData->regionBots[regionIndex];
 
-        return Curvature3D(curv.crv_pdir, curv.crv_c1, curv.crv_c2);
+                facetizeData->regionBots[regionIndex] = 0;
+                facetizeData->resultTriangles->AppendFaces(regionBot->vertices, regionBot->num_vertices, regionBot->faces, regionBot->num_faces);
+                FreeBot(regionBot);
+            }
+
+            ++facetizeData->nextMerge;
+        }
+    }
+    else {
+        BU_UNSETJUMP;
     }
 
-    virtual Curvature3D SurfaceCurvatureOut(void) const {
-        ComputeOutVectors();
+    BU_UNSETJUMP;
+}
 
-        curvature curv;
-        RT_CURVATURE(&curv, m_partition->pt_outhit, m_partition->pt_outflip, m_partition->pt_outseg->seg_stp);
 
-        return Curvature3D(curv.crv_pdir, curv.crv_c1, curv.crv_c2);
-    }
+static void FacetizeWorker
+(
+    int   UNUSED(cpu),
+    void* data
+) {
+    FacetizeData* facetizeData = static_cast<FacetizeData*>(data);
 
-    virtual Mapping2D   Surface2DMappingIn(void) const {
-        uvcoord uv;
-        RT_HIT_UVCOORD(m_application, m_partition->pt_inseg->seg_stp, m_partition->pt_inhit, &uv);
+    // the workers pick their resource slot themselves to be independent of the cpu numbering of bu_parallel()
+    bu_semaphore_acquire(facetizeData->semaphore);
+    size_t threadSlot = facetizeData->nextSlot++;
+    bu_semaphore_release(facetizeData->semaphore);
 
-        return Mapping2D(Vector2D(uv.uv_u, uv.uv_v), Vector2D(uv.uv_du, uv.uv_dv));
-    }
+    resource* resp = facetizeData->resources[threadSlot];
 
-    virtual Mapping2D   Surface2DMappingOut(void) const {
-        uvcoord uv;
-        RT_HIT_UVCOORD(m_application, m_partition->pt_outseg->seg_stp, m_partition->pt_outhit, &uv);
+    // the global vlist free list isn't thread safe
+    bu_list vlfree;
+    BU_LIST_INIT(&vlfree);
 
-        return Mapping2D(Vector2D(uv.uv_u, uv.uv_v), Vector2D(uv.uv_du, uv.uv_dv));
-    }
+    for (;;) {
+        bu_semaphore_acquire(facetizeData->semaphore);
+        size_t regionIndex = facetizeData->nextRegion++;
+        bu_semaphore_release(facetizeData->semaphore);
 
-    virtual bool        HasColor(void) const {
-        return (m_region->reg_mater.ma_color_valid != 0);
-    }
+        if (regionIndex >= facetizeData->numberOfRegions)
+            break;
 
-    virtual double      Red(void) const {
-        return m_region->reg_mater.ma_color[0];
-    }
+        const char*      regionPath  = facetizeData->regionPaths[regionIndex];
+        model*           regionModel = 0;
+        rt_bot_internal* regionBot   = 0;
 
-    virtual double      Green(void) const {
-        return m_region->reg_mater.ma_color[1];
+        if (facetizeData->resultTriangles != 0)
+            regionBot = TriangulateRegion(facetizeData->rtip, resp, &vlfree, regionPath);
+        else
+            regionModel = FacetizeRegion(facetizeData->rtip, resp, &vlfree, regionPath);
+
+        // merging as early as possible keeps only the regions in memory which wait for a predecessor
+        bu_semaphore_acquire(facetizeData->semaphore);
+        facetizeData->regionModels[regionIndex]   = regionModel;
+        facetizeData->regionBots[regionIndex]     = regionBot;
+        facetizeData->regionFinished[regionIndex] = true;
+        MergeFinishedRegions(facetizeData);
+        bu_semaphore_release(facetizeData->semaphore);
     }
 
-    virtual double      Blue(void) const {
-        return m_region->reg_mater.ma_color[2];
-    }
+    bv_vlist_cleanup(&vlfree);
+}
 
-private:
-    application* m_application;
-    partition*   m_partition;
-    region*      m_region;
-    mutable bool m_inVectorsComputed;
-    mutable bool m_outVectorsComputed;
 
-    void ComputeInVectors(void) const {
-        if (!m_inVectorsComputed) {
-            hit* pHit = m_partition->pt_inhit;
+void ConstDatabase::FacetizeIntern
+(
+    const char*          objectName,
+    unsigned int         numberOfThreads,
+    NonManifoldGeometry* nonManifoldGeometry,
+    BagOfTriangles*      triangles
+) const {
+    if (m_rtip != 0) {
+        RegionPathList regionList   = {0, 0, 0};
+        FacetizeData   facetizeData = {m_rtip, m_resources, 0, 0, 0, triangles, 0, 0, 0, 0, 0, 0, 0};
 
-            RT_HIT_NORMAL(pHit->hit_normal, pHit, m_partition->pt_inseg->seg_stp, 0, m_partition->pt_inflip);
-            m_inVectorsComputed = true;
-        }
-    }
+        size_t         threads      = GetThreads(numberOfThreads);
 
-    void ComputeOutVectors(void) const {
-        if (!m_outVectorsComputed) {
-            hit* pHit = m_partition->pt_outhit;
+        if (nonManifoldGeometry != 0)
+            facetizeData.resultModel = nonManifoldGeometry->m_internalp;
 
-            RT_HIT_NORMAL(pHit->hit_normal, pHit, m_partition->pt_outseg->seg_stp, 0, m_partition->pt_outflip);
-            m_outVectorsComputed = true;
-        }
-    }
-};
+        // outside of the jump buffer, ReserveThreadSlots() sets its own one
+        ReserveThreadSlots(threads);
 
+        if (threads > m_numberOfResources)
+            threads = m_numberOfResources;
 
-static int HitDo
-(
+        if (!BU_SETJUMP) {
+            CollectRegionPaths(m_rtip, m_resp, objectName, regionList);
+
+            if (regionList.numberOfPaths > 0) {
+                if (threads > regionList.numberOfPaths)
+                    threads = regionList.numberOfPaths;
+
+                static int semaphore = bu_semaphore_register("BRLCAD_CONSTDATABASE_FACETIZE");
+
+                facetizeData.regionPaths     = regionList.paths;
+                facetizeData.numberOfRegions = regionList.numberOfPaths;
+                facetizeData.regionModels    = static_cast<model**>(bu_calloc(regionList.numberOfPaths, sizeof(model*), "BRLCAD::ConstDatabase::FacetizeIntern::regionModels"));
+                facetizeData.regionBots      = static_cast<rt_bot_internal**>(bu_calloc(regionList.numberOfPaths, sizeof(rt_bot_internal*), "BRLCAD::ConstDatabase::FacetizeIntern::regionBots"));
+                facetizeData.regionFinished  = static_cast<bool*>(bu_calloc(regionList.numberOfPaths, sizeof(bool), "BRLCAD::ConstDatabase::FacetizeIntern::regionFinished"));
+                facetizeData.semaphore       = semaphore;
+
+                bu_parallel(FacetizeWorker, threads, &facetizeData);
+            }
+        }
+        else {
+            BU_UNSETJUMP;
+        }
+
+        BU_UNSETJUMP;
+
+        // leftovers after an error
+        for (size_t i = 0; i < facetizeData.numberOfRegions; ++i) {
+            if ((facetizeData.regionModels != 0) && (facetizeData.regionModels[i] != 0))
+                nmg_km(facetizeData.regionModels[i]);
+
+            if ((facetizeData.regionBots != 0) && (facetizeData.regionBots[i] != 0))
+                FreeBot(facetizeData.regionBots[i]);
+        }
+
+        if (facetizeData.regionModels != 0)
+            bu_free(facetizeData.regionModels, "BRLCAD::ConstDatabase::FacetizeIntern::regionModels");
+
+        if (facetizeData.regionBots != 0)
+            bu_free(facetizeData.regionBots, "BRLCAD::ConstDatabase::FacetizeIntern::regionBots");
+
+        if (facetizeData.regionFinished != 0)
+            bu_free(facetizeData.regionFinished, "BRLCAD::ConstDatabase::FacetizeIntern::regionFinished");
+
+        FreeRegionPaths(regionList);
+    }
+}
+
+
+NonManifoldGeometry* ConstDatabase::Facetize
+(
+    const char*  objectName,
+    unsigned int numberOfThreads
+) const {
+    NonManifoldGeometry* ret = new NonManifoldGeometry;
+
+    FacetizeIntern(objectName, numberOfThreads, ret, 0);
+
+    return ret;
+}
+
+
+BagOfTriangles* ConstDatabase::FacetizeToTriangles
+(
+    const char*  objectName,
+    unsigned int numberOfThreads
+) const {
+    BagOfTriangles* ret = new BagOfTriangles;
+
+    // that's what nmg_mdl_to_bot() produces
+    ret->SetMode(BagOfTriangles::Solid);
+    ret->SetOrientation(BagOfTriangles::CounterClockWise);
+
+    FacetizeIntern(objectName, numberOfThreads, 0, ret);
+
+    return ret;
+}
+
+
+namespace BRLCAD {
+    /// a cached wireframe of an object
+    /** The object's tree is in dependencies, sorted by address to find an object fast on invalidation. */
+    struct PlotCacheEntry {
+        const directory*  object;
+        double            absoluteTolerance;
+        double            relativeTolerance;
+        double            normalTolerance;
+        bu_list*          vlist;
+        size_t            numberOfChunks;
+        const directory** dependencies;
+        size_t            numberOfDependencies;
+        size_t            dependenciesCapacity;
+        size_t            lastUse;              ///< PlotCache::useCounter at the last hit
+    };
+
+    /// the wireframes of the recently plotted objects, at most PlotCacheMaxChunks vlist chunks
+    /** If the limit is reached the least recently used entries are removed. */
+    struct PlotCache {
+        PlotCacheEntry* entries;
+        size_t          numberOfEntries;
+        size_t          capacity;
+        size_t          numberOfChunks;
+        size_t          useCounter;
+    };
+}
+
+
+// about 1 kB each
+static const size_t PlotCacheMaxChunks = 8192;
+
+
+static int PlotCacheSemaphore(void) {
+    static int semaphore = bu_semaphore_register("BRLCAD_CONSTDATABASE_PLOTCACHE");
+
+    return semaphore;
+}
+
+
+static void FreePlotCacheEntry
+(
+    PlotCacheEntry& entry
+) {
+    if (entry.vlist != 0) {
+        RT_FREE_VLIST(entry.vlist);
+        bu_free(entry.vlist, "BRLCAD::ConstDatabase::FreePlotCacheEntry::vlist");
+        entry.vlist          = 0;
+        entry.numberOfChunks = 0;
+    }
+
+    if (entry.dependencies != 0) {
+        bu_free(entry.dependencies, "BRLCAD::ConstDatabase::FreePlotCacheEntry::dependencies");
+        entry.dependencies         = 0;
+        entry.numberOfDependencies = 0;
+        entry.dependenciesCapacity = 0;
+    }
+}
+
+
+static PlotCacheEntry* FindPlotCacheEntry
+(
+    PlotCache&       plotCache,
+    const directory* pDir,
+    double           absoluteTolerance,
+    double           relativeTolerance,
+    double           normalTolerance
+) {
+    PlotCacheEntry* ret = 0;
+
+    if (pDir != RT_DIR_NULL) {
+        for (size_t i = 0; i < plotCache.numberOfEntries; ++i) {
+            PlotCacheEntry& entry = plotCache.entries[i];
+
+            if ((entry.object == pDir) &&
+                (entry.absoluteTolerance == absoluteTolerance) &&
+                (entry.relativeTolerance == relativeTolerance) &&
+                (entry.normalTolerance == normalTolerance)) {
+                ret = &entry;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+static size_t NumberOfChunks
+(
+    bu_list* vlist
+) {
+    size_t    ret = 0;
+    bv_vlist* chunk;
+
+    for (BU_LIST_FOR(chunk, bv_vlist, vlist))
+        ++ret;
+
+    return ret;
+}
+
+
+/// removes the least recently used entries until \a numberOfChunks chunks more fit into the cache
+static void MakeRoomInPlotCache
+(
+    PlotCache& plotCache,
+    size_t     numberOfChunks
+) {
+    while ((plotCache.numberOfEntries > 0) && (plotCache.numberOfChunks + numberOfChunks > PlotCacheMaxChunks)) {
+        size_t leastRecentlyUsed = 0;
+
+        for (size_t i = 1; i < plotCache.numberOfEntries; ++i) {
+            if (plotCache.entries[i].lastUse < plotCache.entries[leastRecentlyUsed].lastUse)
+                leastRecentlyUsed = i;
+        }
+
+        plotCache.numberOfChunks -= plotCache.entries[leastRecentlyUsed].numberOfChunks;
+        FreePlotCacheEntry(plotCache.entries[leastRecentlyUsed]);
+
+        // the order of the entries doesn't matter
+        --plotCache.numberOfEntries;
+        plotCache.entries[leastRecentlyUsed] = plotCache.entries[plotCache.numberOfEntries];
+    }
+}
+
+
+/// db_functree() callback for the combinations and leaves of a cached object
+static void AddDependency
+(
+    db_i*      UNUSED(dbip),
+    directory* pDir,
+    void*      clientData
+) {
+    PlotCacheEntry* entry = static_cast<PlotCacheEntry*>(clientData);
+
+    if (entry->numberOfDependencies == entry->dependenciesCapacity) {
+        size_t newCapacity = (entry->dependenciesCapacity > 0) ? 2 * entry->dependenciesCapacity : 16;
+
+        entry->dependencies         = static_cast<const directory**>(bu_realloc(entry->dependencies, newCapacity * sizeof(const directory*), "BRLCAD::ConstDatabase::AddDependency::dependencies"));
+        entry->dependenciesCapacity = newCapacity;
+    }
+
+    entry->dependencies[entry->numberOfDependencies] = pDir;
+    ++entry->numberOfDependencies;
+}
+
+
+static int CompareDirectories
+(
+    const void* a,
+    const void* b
+) {
+    const directory* first  = *static_cast<const directory* const*>(a);
+    const directory* second = *static_cast<const directory* const*>(b);
+    int              ret    = 0;
+
+    if (first < second)
+        ret = -1;
+    else if (first > second)
+        ret = 1;
+
+    return ret;
+}
+
+
+/// sorts the dependencies and removes the duplicates of instanced subtrees
+static void SortDependencies
+(
+    PlotCacheEntry& entry
+) {
+    if (entry.numberOfDependencies > 1) {
+        qsort(entry.dependencies, entry.numberOfDependencies, sizeof(const directory*), CompareDirectories);
+
+        size_t numberOfUniqueDependencies = 1;
+
+        for (size_t i = 1; i < entry.numberOfDependencies; ++i) {
+            if (entry.dependencies[i] != entry.dependencies[numberOfUniqueDependencies - 1]) {
+                entry.dependencies[numberOfUniqueDependencies] = entry.dependencies[i];
+                ++numberOfUniqueDependencies;
+            }
+        }
+
+        entry.numberOfDependencies = numberOfUniqueDependencies;
+    }
+}
+
+
+static bool DependsOn
+(
+    const PlotCacheEntry& entry,
+    const directory*      pDir
+) {
+    return (entry.numberOfDependencies > 0) &&
+           (bsearch(&pDir, entry.dependencies, entry.numberOfDependencies, sizeof(const directory*), CompareDirectories) != 0);
+}
+
+
+static tree* PlotLeaf
+(
+    db_tree_state*      tsp,
+    const db_full_path* pathp,
+    rt_db_internal*     ip,
+    void*               clientData
+) {
+    tree*    ret   = TREE_NULL;
+    bu_list* vlist = static_cast<bu_list*>(clientData);
+
+    if (ip->idb_meth->ft_plot != 0) {
+        if (ip->idb_meth->ft_plot(vlist, ip, tsp->ts_ttol, tsp->ts_tol, 0) == 0) {
+            // Indicate success by returning something other than TREE_NULL
+            BU_GET(ret, tree);
+            RT_TREE_INIT(ret);
+            ret->tr_op = OP_NOP;
+        }
+    }
+
+    return ret;
+}
+
+
+static int VlistFreeSemaphore(void) {
+    static int semaphore = bu_semaphore_register("BRLCAD_CONSTDATABASE_VLFREE");
+
+    return semaphore;
+}
+
+
+/// the plot functions which only append to their vector list
+/** All plot functions take their chunks from librt's global free list RTG.rtg_vlfree.
+    While the workers of the parallel Plot() run this list is empty, i.e. every plot function allocates new chunks
+    for its own list, which is safe as long as it doesn't return temporary chunks to RTG.rtg_vlfree. */
+static bool PlotsInParallel
+(
+    const rt_db_internal& intern
+) {
+    bool ret = false;
+
+    if (intern.idb_major_type == DB5_MAJORTYPE_BRLCAD) {
+        switch (intern.idb_type) {
+            case ID_TOR:
+            case ID_TGC:
+            case ID_ELL:
+            case ID_ARB8:
+            case ID_HALF:
+            case ID_REC:
+            case ID_SPH:
+            case ID_ARBN:
+            case ID_PIPE:
+            case ID_PARTICLE:
+            case ID_RPC:
+            case ID_RHC:
+            case ID_EPA:
+            case ID_EHY:
+            case ID_ETO:
+            case ID_BOT:
+                ret = true;
+        }
+    }
+
+    return ret;
+}
+
+
+/// the wireframe of a region of the parallel Plot()
+struct RegionPlot {
+    bu_list vlist;
+    bool    deferred; ///< the region contains a solid which can't be plotted in parallel, it's plotted after the workers
+};
+
+
+/// PlotLeaf() for concurrent tree walks
+static tree* PlotLeafParallel
+(
+    db_tree_state*      tsp,
+    const db_full_path* pathp,
+    rt_db_internal*     ip,
+    void*               clientData
+) {
+    tree*       ret        = TREE_NULL;
+    RegionPlot* regionPlot = static_cast<RegionPlot*>(clientData);
+
+    if (!regionPlot->deferred) {
+        if (PlotsInParallel(*ip))
+            ret = PlotLeaf(tsp, pathp, ip, &regionPlot->vlist);
+        else
+            regionPlot->deferred = true;
+    }
+
+    return ret;
+}
+
+
+void ConstDatabase::Plot
+(
+    const char* objectName,
+    VectorList& vectorList
+) const {
+    if ((m_rtip != 0) && !PlotFromCache(objectName, vectorList)) {
+        VectorList plot;
+        bool       plotted = false;
+
+        // not while a parallel Plot() has put the free chunks aside
+        bu_semaphore_acquire(VlistFreeSemaphore());
+
+        if (!BU_SETJUMP) {
+            db_tree_state initState;
+
+            db_init_db_tree_state(&initState, m_rtip->rti_dbip, m_resp);
+            initState.ts_ttol = &m_rtip->rti_ttol;
+            initState.ts_tol  = &m_rtip->rti_tol;
+
+            db_walk_tree(m_rtip->rti_dbip,
+                         1,
+                         &objectName,
+                         1,
+                         &initState,
+                         0,
+                         0,
+                         PlotLeaf,
+                         plot.m_vlist);
+
+            plotted = true;
+        }
+        else
+            BU_UNSETJUMP;
+
+        BU_UNSETJUMP;
+
+        bu_semaphore_release(VlistFreeSemaphore());
+
+        if (plotted)
+            AddToPlotCache(objectName, plot);
+
+        BU_LIST_APPEND_LIST(vectorList.m_vlist, plot.m_vlist);
+    }
+}
+
+
+struct PlotData {
+    rt_i*       rtip;
+    resource**  resources;
+    char**      regionPaths;
+    RegionPlot* regionPlots;
+    size_t      numberOfRegions;
+    int         semaphore;
+    size_t      nextSlot;
+    size_t      nextRegion;
+};
+
+
+static void PlotWorker
+(
+    int   UNUSED(cpu),
+    void* data
+) {
+    PlotData* plotData = static_cast<PlotData*>(data);
+
+    // the workers pick their resource slot themselves to be independent of the cpu numbering of bu_parallel()
+    bu_semaphore_acquire(plotData->semaphore);
+    size_t threadSlot = plotData->nextSlot++;
+    bu_semaphore_release(plotData->semaphore);
+
+    for (;;) {
+        bu_semaphore_acquire(plotData->semaphore);
+        size_t regionIndex = plotData->nextRegion++;
+        bu_semaphore_release(plotData->semaphore);
+
+        if (regionIndex >= plotData->numberOfRegions)
+            break;
+
+        if (!BU_SETJUMP) {
+            const char*   regionPath = plotData->regionPaths[regionIndex];
+            db_tree_state initState;
+
+            db_init_db_tree_state(&initState, plotData->rtip->rti_dbip, plotData->resources[threadSlot]);
+            initState.ts_ttol = &plotData->rtip->rti_ttol;
+            initState.ts_tol  = &plotData->rtip->rti_tol;
+
+            db_walk_tree(plotData->rtip->rti_dbip,
+                         1,
+                         &regionPath,
+                         1,
+                         &initState,
+                         0,
+                         0,
+                         PlotLeafParallel,
+                         plotData->regionPlots + regionIndex);
+        }
+        else {
+            BU_UNSETJUMP;
+        }
+
+        BU_UNSETJUMP;
+    }
+}
+
+
+void ConstDatabase::Plot
+(
+    const char*  objectName,
+    VectorList&  vectorList,
+    unsigned int numberOfThreads
+) const {
+    if ((m_rtip != 0) && !PlotFromCache(objectName, vectorList)) {
+        VectorList     plot;
+        bool           plotted    = false;
+        RegionPathList regionList = {0, 0, 0};
+        PlotData       plotData   = {m_rtip, m_resources, 0, 0, 0, 0, 0, 0};
+        size_t         threads    = GetThreads(numberOfThreads);
+        bu_list        vlfree;
+
+        // outside of the jump buffer, ReserveThreadSlots() sets its own one
+        ReserveThreadSlots(threads);
+
+        if (threads > m_numberOfResources)
+            threads = m_numberOfResources;
+
+        // the free chunks are put aside, the workers allocate new ones
+        bu_semaphore_acquire(VlistFreeSemaphore());
+        BU_LIST_INIT(&vlfree);
+        BU_LIST_APPEND_LIST(&vlfree, &RTG.rtg_vlfree);
+
+        if (!BU_SETJUMP) {
+            CollectRegionPaths(m_rtip, m_resp, objectName, regionList);
+
+            if (regionList.numberOfPaths > 0) {
+                if (threads > regionList.numberOfPaths)
+                    threads = regionList.numberOfPaths;
+
+                static int semaphore = bu_semaphore_register("BRLCAD_CONSTDATABASE_PLOT");
+
+                plotData.regionPaths = regionList.paths;
+                plotData.regionPlots = static_cast<RegionPlot*>(bu_calloc(regionList.numberOfPaths, sizeof(RegionPlot), "BRLCAD::ConstDatabase::Plot::regionPlots"));
+
+                for (size_t i = 0; i < regionList.numberOfPaths; ++i)
+                    BU_LIST_INIT(&plotData.regionPlots[i].vlist);
+
+                plotData.numberOfRegions = regionList.numberOfPaths;
+                plotData.semaphore       = semaphore;
+
+                bu_parallel(PlotWorker, threads, &plotData);
+
+                // the regions with other solids one after another
+                for (size_t i = 0; i < plotData.numberOfRegions; ++i) {
+                    RegionPlot& regionPlot = plotData.regionPlots[i];
+
+                    if (regionPlot.deferred) {
+                        const char*   regionPath = plotData.regionPaths[i];
+                        db_tree_state initState;
+
+                        RT_FREE_VLIST(&regionPlot.vlist);
+
+                        db_init_db_tree_state(&initState, m_rtip->rti_dbip, m_resp);
+                        initState.ts_ttol = &m_rtip->rti_ttol;
+                        initState.ts_tol  = &m_rtip->rti_tol;
+
+                        db_walk_tree(m_rtip->rti_dbip,
+                                     1,
+                                     &regionPath,
+                                     1,
+                                     &initState,
+                                     0,
+                                     0,
+                                     PlotLeaf,
+                                     &regionPlot.vlist);
+                    }
+                }
+            }
+
+            plotted = true;
+        }
+        else {
+            BU_UNSETJUMP;
+        }
+
+        BU_UNSETJUMP;
+
+        // the chunks put aside and the temporary ones of the deferred regions
+        BU_LIST_APPEND_LIST(&RTG.rtg_vlfree, &vlfree);
+        bu_semaphore_release(VlistFreeSemaphore());
+
+        // moving the chunk lists costs nothing, the order of the regions keeps the result deterministic
+        for (size_t i = 0; i < plotData.numberOfRegions; ++i)
+            BU_LIST_APPEND_LIST(plot.m_vlist, &plotData.regionPlots[i].vlist);
+
+        if (plotData.regionPlots != 0)
+            bu_free(plotData.regionPlots, "BRLCAD::ConstDatabase::Plot::regionPlots");
+
+        FreeRegionPaths(regionList);
+
+        if (plotted)
+            AddToPlotCache(objectName, plot);
+
+        BU_LIST_APPEND_LIST(vectorList.m_vlist, plot.m_vlist);
+    }
+}
+
+
+void ConstDatabase::InvalidatePlotCache
+(
+    const directory* pDir
+) const {
+    if (m_plotCache != 0) {
+        bu_semaphore_acquire(PlotCacheSemaphore());
+
+        size_t numberOfKeptEntries = 0;
+
+        for (size_t i = 0; i < m_plotCache->numberOfEntries; ++i) {
+            PlotCacheEntry& entry = m_plotCache->entries[i];
+
+            if ((pDir == 0) || DependsOn(entry, pDir)) {
+                m_plotCache->numberOfChunks -= entry.numberOfChunks;
+                FreePlotCacheEntry(entry);
+            }
+            else {
+                m_plotCache->entries[numberOfKeptEntries] = entry;
+                ++numberOfKeptEntries;
+            }
+        }
+
+        m_plotCache->numberOfEntries = numberOfKeptEntries;
+
+        bu_semaphore_release(PlotCacheSemaphore());
+    }
+}
+
+
+bool ConstDatabase::PlotFromCache
+(
+    const char* objectName,
+    VectorList& vectorList
+) const {
+    bool ret = false;
+
+    if (m_plotCache != 0) {
+        bu_semaphore_acquire(PlotCacheSemaphore());
+
+        if (!BU_SETJUMP) {
+            directory*      pDir  = db_lookup(m_rtip->rti_dbip, objectName, LOOKUP_QUIET);
+            PlotCacheEntry* entry = FindPlotCacheEntry(*m_plotCache, pDir, m_rtip->rti_ttol.abs, m_rtip->rti_ttol.rel, m_rtip->rti_ttol.norm);
+
+            if (entry != 0) {
+                bv_vlist_copy(&RTG.rtg_vlfree, vectorList.m_vlist, entry->vlist);
+                entry->lastUse = ++m_plotCache->useCounter;
+                ret            = true;
+            }
+        }
+        else
+            BU_UNSETJUMP;
+
+        BU_UNSETJUMP;
+
+        bu_semaphore_release(PlotCacheSemaphore());
+    }
+
+    return ret;
+}
+
+
+void ConstDatabase::AddToPlotCache
+(
+    const char*       objectName,
+    const VectorList& plot
+) const {
+    bu_semaphore_acquire(PlotCacheSemaphore());
+
+    PlotCacheEntry newEntry = {0, 0., 0., 0., 0, 0, 0, 0, 0, 0};
+
+    if (!BU_SETJUMP) {
+        // paths and lists of names are not cached, and plots which would displace a big part of the cache
+        directory* pDir           = db_lookup(m_rtip->rti_dbip, objectName, LOOKUP_QUIET);
+        size_t     numberOfChunks = NumberOfChunks(plot.m_vlist);
+
+        if ((pDir != RT_DIR_NULL) && (numberOfChunks <= (PlotCacheMaxChunks / 4))) {
+            if (m_plotCache == 0)
+                m_plotCache = static_cast<PlotCache*>(bu_calloc(1, sizeof(PlotCache), "BRLCAD::ConstDatabase::AddToPlotCache::m_plotCache"));
+
+            if (FindPlotCacheEntry(*m_plotCache, pDir, m_rtip->rti_ttol.abs, m_rtip->rti_ttol.rel, m_rtip->rti_ttol.norm) == 0) {
+                newEntry.object            = pDir;
+                newEntry.absoluteTolerance = m_rtip->rti_ttol.abs;
+                newEntry.relativeTolerance = m_rtip->rti_ttol.rel;
+                newEntry.normalTolerance   = m_rtip->rti_ttol.norm;
+                newEntry.lastUse           = ++m_plotCache->useCounter;
+
+                MakeRoomInPlotCache(*m_plotCache, numberOfChunks);
+
+                BU_ALLOC(newEntry.vlist, bu_list);
+                BU_LIST_INIT(newEntry.vlist);
+                bv_vlist_copy(&RTG.rtg_vlfree, newEntry.vlist, plot.m_vlist);
+                newEntry.numberOfChunks = NumberOfChunks(newEntry.vlist);
+
+                db_functree(m_rtip->rti_dbip, pDir, AddDependency, AddDependency, m_resp, &newEntry);
+                SortDependencies(newEntry);
+
+                if (m_plotCache->numberOfEntries == m_plotCache->capacity) {
+                    size_t newCapacity = (m_plotCache->capacity > 0) ? 2 * m_plotCache->capacity : 8;
+
+                    m_plotCache->entries  = static_cast<PlotCacheEntry*>(bu_realloc(m_plotCache->entries, newCapacity * sizeof(PlotCacheEntry), "BRLCAD::ConstDatabase::AddToPlotCache::entries"));
+                    m_plotCache->capacity = newCapacity;
+                }
+
+                m_plotCache->entries[m_plotCache->numberOfEntries] = newEntry;
+                ++m_plotCache->numberOfEntries;
+                m_plotCache->numberOfChunks += newEntry.numberOfChunks;
+                newEntry.vlist        = 0;
+                newEntry.dependencies = 0;
+            }
+        }
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+
+    // left over after an error
+    FreePlotCacheEntry(newEntry);
+
+    bu_semaphore_release(PlotCacheSemaphore());
+}
+
+
+static int PrepSemaphore(void) {
+    static int semaphore = bu_semaphore_register("BRLCAD_CONSTDATABASE_PREP");
+
+    return semaphore;
+}
+
+
+static void PrepareForRaytracing
+(
+    rt_i*   rtip,
+    int     numberOfThreads,
+    double& prepTime
+) {
+    // rt_prep_parallel() clears needprep before the rt_i is ready, it can only be read under the semaphore
+    bu_semaphore_acquire(PrepSemaphore());
+
+    if (!BU_SETJUMP) {
+        if (rtip->needprep) {
+            int64_t start = bu_gettime();
+
+            rt_prep_parallel(rtip, numberOfThreads);
+
+            prepTime = (bu_gettime() - start) / 1e6;
+        }
+    }
+
+    BU_UNSETJUMP;
+
+    bu_semaphore_release(PrepSemaphore());
+}
+
+
+// marks hidden regions in region::reg_udata and the rt_i with hidden regions in rt_i::rti_udata
+static char HiddenRegionMarker = 0;
+
+
+static bool RegionIsHidden
+(
+    const region* reg
+) {
+    return reg->reg_udata == &HiddenRegionMarker;
+}
+
+
+/// with hidden regions librt has to return all partitions, the first visible one is picked out by the hit functions
+static int OneHit
+(
+    const rt_i* rtip,
+    int         flags
+) {
+    int ret = 0;
+
+    if (rtip->rti_udata != &HiddenRegionMarker)
+        ret = flags & ConstDatabase::StopAfterFirstHit;
+
+    return ret;
+}
+
+
+/// tests if the region path \a path starts with one of the objects in \a objectNames
+/** \a objectNames may be a space separated list of object names as accepted by Select(). */
+static bool PathStartsWith
+(
+    const char* path,
+    const char* objectNames
+) {
+    bool ret = false;
+
+    if (path[0] == '/') {
+        const char* objectName = objectNames;
+
+        while (!ret && (*objectName != '\0')) {
+            while (*objectName == ' ')
+                ++objectName;
+
+            size_t length = 0;
+
+            while ((objectName[length] != '\0') && (objectName[length] != ' '))
+                ++length;
+
+            if ((length > 0) && (strncmp(path + 1, objectName, length) == 0))
+                ret = (path[length + 1] == '/') || (path[length + 1] == '\0');
+
+            objectName += length;
+        }
+    }
+
+    return ret;
+}
+
+
+void ConstDatabase::Select
+(
+    const char* objectName
+) {
+    if (m_rtip != 0) {
+        int64_t start = bu_gettime();
+
+        if (!BU_SETJUMP) {
+            rt_gettree(m_rtip, objectName);
+            AppendToSelectionList(objectName);
+        }
+
+        BU_UNSETJUMP;
+
+        m_selectTime += (bu_gettime() - start) / 1e6;
+    }
+}
+
+
+void ConstDatabase::Select
+(
+    const char** objectNames,
+    size_t       numberOfObjectNames,
+    unsigned int numberOfThreads
+) {
+    if ((m_rtip != 0) && (objectNames != 0) && (numberOfObjectNames > 0)) {
+        int64_t start   = bu_gettime();
+        size_t  threads = GetThreads(numberOfThreads);
+
+        // the tree walk takes the resource of each cpu from the rt_i, without one the cpus share rt_uniresource
+        ReserveThreadSlots(threads);
+
+        if (threads > m_numberOfResources)
+            threads = m_numberOfResources;
+
+        if (!BU_SETJUMP) {
+            rt_gettrees(m_rtip, static_cast<int>(numberOfObjectNames), objectNames, static_cast<int>(threads));
+
+            for (size_t i = 0; i < numberOfObjectNames; ++i)
+                AppendToSelectionList(objectNames[i]);
+        }
+
+        BU_UNSETJUMP;
+
+        m_selectTime += (bu_gettime() - start) / 1e6;
+    }
+}
+
+
+void ConstDatabase::UnSelectAll(void) {
+    if (m_rtip != 0) {
+        if (!BU_SETJUMP)
+            rt_clean(m_rtip);
+
+        BU_UNSETJUMP;
+
+        m_selectTime = 0.;
+        m_prepTime   = 0.;
+    }
+
+    ClearSelectionList();
+}
+
+
+void ConstDatabase::AddToSelection
+(
+    const char* objectName
+) {
+    if ((m_rtip != 0) && (objectName != 0)) {
+        size_t index = 0;
+
+        while ((index < m_numberOfSelectedObjects) && (strcmp(m_selectedObjects[index], objectName) != 0))
+            ++index;
+
+        if (index < m_numberOfSelectedObjects) {
+            if (m_selectedObjectHidden[index]) {
+                // still loaded and prepared
+                m_selectedObjectHidden[index] = false;
+                UpdateHiddenRegions();
+            }
+        }
+        else if (m_rtip->needprep)
+            Select(objectName);
+        else {
+            // librt doesn't load further trees into a prepared rt_i, this is a full UnSelectAll() and re-prep
+            AppendToSelectionList(objectName);
+            Reselect();
+        }
+    }
+}
+
+
+void ConstDatabase::RemoveFromSelection
+(
+    const char* objectName
+) {
+    if ((m_rtip != 0) && (objectName != 0)) {
+        size_t numberOfVisibleObjects = 0;
+        bool   changed                = false;
+
+        for (size_t i = 0; i < m_numberOfSelectedObjects; ++i) {
+            if (!m_selectedObjectHidden[i] && (strcmp(m_selectedObjects[i], objectName) == 0)) {
+                m_selectedObjectHidden[i] = true;
+                changed                   = true;
+            }
+
+            if (!m_selectedObjectHidden[i])
+                ++numberOfVisibleObjects;
+        }
+
+        if (changed) {
+            if (numberOfVisibleObjects == 0)
+                UnSelectAll();
+            else
+                UpdateHiddenRegions();
+        }
+    }
+}
+
+
+void ConstDatabase::AppendToSelectionList
+(
+    const char* objectName
+) {
+    m_selectedObjects      = static_cast<char**>(bu_realloc(m_selectedObjects, (m_numberOfSelectedObjects + 1) * sizeof(char*), "BRLCAD::ConstDatabase::AppendToSelectionList::m_selectedObjects"));
+    m_selectedObjectHidden = static_cast<bool*>(bu_realloc(m_selectedObjectHidden, (m_numberOfSelectedObjects + 1) * sizeof(bool), "BRLCAD::ConstDatabase::AppendToSelectionList::m_selectedObjectHidden"));
+
+    m_selectedObjects[m_numberOfSelectedObjects]      = bu_strdup(objectName);
+    m_selectedObjectHidden[m_numberOfSelectedObjects] = false;
+    ++m_numberOfSelectedObjects;
+}
+
+
+void ConstDatabase::ClearSelectionList(void) {
+    for (size_t i = 0; i < m_numberOfSelectedObjects; ++i)
+        bu_free(m_selectedObjects[i], "BRLCAD::ConstDatabase::ClearSelectionList::m_selectedObjects[i]");
+
+    if (m_selectedObjects != 0)
+        bu_free(m_selectedObjects, "BRLCAD::ConstDatabase::ClearSelectionList::m_selectedObjects");
+
+    if (m_selectedObjectHidden != 0)
+        bu_free(m_selectedObjectHidden, "BRLCAD::ConstDatabase::ClearSelectionList::m_selectedObjectHidden");
+
+    m_selectedObjects         = 0;
+    m_selectedObjectHidden    = 0;
+    m_numberOfSelectedObjects = 0;
+}
+
+
+/** A region is hidden if its path starts with a hidden object but with none of the visible ones. */
+void ConstDatabase::UpdateHiddenRegions(void) {
+    bool    hiddenRegions = false;
+    region* reg;
+
+    for (BU_LIST_FOR(reg, region, &m_rtip->HeadRegion)) {
+        bool hidden = false;
+
+        for (size_t i = 0; i < m_numberOfSelectedObjects; ++i) {
+            if (PathStartsWith(reg->reg_name, m_selectedObjects[i])) {
+                if (m_selectedObjectHidden[i])
+                    hidden = true;
+                else {
+                    hidden = false;
+                    break;
+                }
+            }
+        }
+
+        if (hidden) {
+            reg->reg_udata = &HiddenRegionMarker;
+            hiddenRegions  = true;
+        }
+        else
+            reg->reg_udata = 0;
+    }
+
+    m_rtip->rti_udata = hiddenRegions ? &HiddenRegionMarker : 0;
+}
+
+
+/// rebuilds the active set from the visible objects of the selection list
+void ConstDatabase::Reselect(void) {
+    size_t       numberOfObjects = 0;
+    const char** objectNames     = static_cast<const char**>(bu_calloc(m_numberOfSelectedObjects + 1, sizeof(char*), "BRLCAD::ConstDatabase::Reselect::objectNames"));
+
+    for (size_t i = 0; i < m_numberOfSelectedObjects; ++i) {
+        if (!m_selectedObjectHidden[i]) {
+            objectNames[numberOfObjects] = bu_strdup(m_selectedObjects[i]);
+            ++numberOfObjects;
+        }
+    }
+
+    UnSelectAll();
+    Select(objectNames, numberOfObjects);
+
+    for (size_t i = 0; i < numberOfObjects; ++i)
+        bu_free(const_cast<char*>(objectNames[i]), "BRLCAD::ConstDatabase::Reselect::objectNames[i]");
+
+    bu_free(objectNames, "BRLCAD::ConstDatabase::Reselect::objectNames");
+}
+
+
+bool ConstDatabase::SelectionIsEmpty(void) const {
+    bool ret = true;
+
+    if (m_rtip != 0)
+        ret = m_rtip->nsolids < 1;
+
+    return ret;
+}
+
+
+void ConstDatabase::Prepare
+(
+    unsigned int numberOfThreads
+) const {
+    if (!SelectionIsEmpty())
+        PrepareForRaytracing(m_rtip, GetThreads(numberOfThreads), m_prepTime);
+}
+
+
+ConstDatabase::PrepStatistics ConstDatabase::PreparationStatistics(void) const {
+    PrepStatistics ret;
+
+    if (m_rtip != 0) {
+        ret.selectTime      = m_selectTime;
+        ret.numberOfSolids  = m_rtip->nsolids;
+        ret.numberOfRegions = m_rtip->nregions;
+
+        if (!m_rtip->needprep) {
+            ret.prepTime         = m_prepTime;
+            ret.numberOfCutNodes = m_rtip->rti_ncut_by_type[CUT_CUTNODE];
+            ret.numberOfBoxNodes = m_rtip->rti_ncut_by_type[CUT_BOXNODE];
+            ret.maximumCutDepth  = m_rtip->rti_cut_maxdepth;
+        }
+    }
+
+    return ret;
+}
+
+
+Vector3D ConstDatabase::BoundingBoxMinima(void) const {
+    Vector3D ret;
+
+    if (!SelectionIsEmpty()) {
+        PrepareForRaytracing(m_rtip, 1, m_prepTime);
+        VMOVE(ret.coordinates, m_rtip->mdl_min);
+    }
+
+    return ret;
+}
+
+
+Vector3D ConstDatabase::BoundingBoxMaxima(void) const {
+    Vector3D ret;
+
+    if (!SelectionIsEmpty()) {
+        PrepareForRaytracing(m_rtip, 1, m_prepTime);
+        VMOVE(ret.coordinates, m_rtip->mdl_max);
+    }
+
+    return ret;
+}
+
+
+class ConstDatabaseHit : public ConstDatabase::Hit {
+public:
+    ConstDatabaseHit(application* ap,
+                     partition*   part,
+                     region*      reg) : ConstDatabase::Hit(),
+                                                  m_application(ap),
+                                                  m_partition(part),
+                                                  m_region(reg),
+                                                  m_inVectorsComputed(false),
+                                                  m_outVectorsComputed(false) {
+        assert(m_application != 0);
+        assert(m_partition != 0);
+        assert(m_region != 0);
+   }
+
+    virtual const char* Name(void) const {
+        return m_region->reg_name;
+    }
+
+    virtual double      DistanceIn(void) const {
+        return m_partition->pt_inhit->hit_dist;
+    }
+
+    virtual double      DistanceOut(void) const {
+        return m_partition->pt_outhit->hit_dist;
+    }
+
+    virtual Vector3D    PointIn(void) const {
+        ComputeInVectors();
+        return m_partition->pt_inhit->hit_point;
+    }
+
+    virtual Vector3D    PointOut(void) const {
+        ComputeOutVectors();
+        return m_partition->pt_outhit->hit_point;
+    }
+
+    virtual Vector3D    SurfaceNormalIn(void) const {
+        ComputeInVectors();
+        return m_partition->pt_inhit->hit_normal;
+    }
+
+    virtual Vector3D    SurfaceNormalOut(void) const {
+        ComputeOutVectors();
+        return m_partition->pt_outhit->hit_normal;
+    }
+
+    virtual Curvature3D SurfaceCurvatureIn(void) const {
+        ComputeInVectors();
+
+        curvature curv;
+        RT_CURVATURE(&curv, m_partition->pt_inhit, m_partition->pt_inflip, m_partition->pt_inseg->seg_stp);
+
+        return Curvature3D(curv.crv_pdir, curv.crv_c1, curv.crv_c2);
+    }
+
+    virtual Curvature3D SurfaceCurvatureOut(void) const {
+        ComputeOutVectors();
+
+        curvature curv;
+        RT_CURVATURE(&curv, m_partition->pt_outhit, m_partition->pt_outflip, m_partition->pt_outseg->seg_stp);
+
+        return Curvature3D(curv.crv_pdir, curv.crv_c1, curv.crv_c2);
+    }
+
+    virtual Mapping2D   Surface2DMappingIn(void) const {
+        uvcoord uv;
+        RT_HIT_UVCOORD(m_application, m_partition->pt_inseg->seg_stp, m_partition->pt_inhit, &uv);
+
+        return Mapping2D(Vector2D(uv.uv_u, uv.uv_v), Vector2D(uv.uv_du, uv.uv_dv));
+    }
+
+    virtual Mapping2D   Surface2DMappingOut(void) const {
+        uvcoord uv;
+        RT_HIT_UVCOORD(m_application, m_partition->pt_outseg->seg_stp, m_partition->pt_outhit, &uv);
+
+        return Mapping2D(Vector2D(uv.uv_u, uv.uv_v), Vector2D(uv.uv_du, uv.uv_dv));
+    }
+
+    virtual bool        HasColor(void) const {
+        return (m_region->reg_mater.ma_color_valid != 0);
+    }
+
+    virtual double      Red(void) const {
+        return m_region->reg_mater.ma_color[0];
+    }
+
+    virtual double      Green(void) const {
+        return m_region->reg_mater.ma_color[1];
+    }
+
+    virtual double      Blue(void) const {
+        return m_region->reg_mater.ma_color[2];
+    }
+
+private:
+    application* m_application;
+    partition*   m_partition;
+    region*      m_region;
+    mutable bool m_inVectorsComputed;
+    mutable bool m_outVectorsComputed;
+
+    void ComputeInVectors(void) const {
+        if (!m_inVectorsComputed) {
+            hit* pHit = m_partition->pt_inhit;
+
+            RT_HIT_NORMAL(pHit->hit_normal, pHit, m_partition->pt_inseg->seg_stp, 0, m_partition->pt_inflip);
+            m_inVectorsComputed = true;
+        }
+    }
+
+    void ComputeOutVectors(void) const {
+        if (!m_outVectorsComputed) {
+            hit* pHit = m_partition->pt_outhit;
+
+            RT_HIT_NORMAL(pHit->hit_normal, pHit, m_partition->pt_outseg->seg_stp, 0, m_partition->pt_outflip);
+            m_outVectorsComputed = true;
+        }
+    }
+};
+
+
+static int HitDo
+(
     application* ap,
     partition*   partitionHead,
     seg*         UNUSED(segment)
@@ -745,10 +2070,18 @@ static int HitDo
         for (partition* part = partitionHead->pt_forw;
              part != partitionHead;
              part = part->pt_forw) {
+            if (RegionIsHidden(part->pt_regionp))
+                continue;
+
             if (!((*callback)(ConstDatabaseHit(ap, part, part->pt_regionp)))) {
                 ret = 1;
                 break;
             }
+
+            if (ap->a_user & ConstDatabase::StopAfterFirstHit) {
+                ret = 1;
+                break;
+            }
         }
     }
 
@@ -794,29 +2127,269 @@ void ConstDatabase::ShootRay
 }
 
 
-static void MultioverlapDo
+static void MultioverlapDo
+(
+    application* ap,
+    partition*   part,
+    bu_ptbl*     regiontable,
+    partition*   UNUSED(inputHdp)
+) {
+    ConstDatabase::HitCallback* callback = static_cast<ConstDatabase::HitCallback*>(ap->a_uptr);
+    int&                        ret      = ap->a_return;
+
+    if (ret == 0) {
+        for (size_t i = 0; i < BU_PTBL_LEN(regiontable); ++i) {
+            region* reg = reinterpret_cast<region*>(BU_PTBL_GET(regiontable, i));
+
+            if (reg == REGION_NULL)
+                continue;
+
+            RT_CK_REGION(reg);
+
+            if (RegionIsHidden(reg))
+                continue;
+
+            if (!((*callback)(ConstDatabaseHit(ap, part, reg)))) {
+                ret = 1;
+                break;
+            }
+        }
+    }
+
+    bu_ptbl_reset(regiontable);
+}
+
+
+void ConstDatabase::ShootRay
+(
+    const Ray3D& ray,
+    HitCallback& callback,
+    int          flags
+) const {
+    ShootRay(ray, callback, flags, 0);
+}
+
+
+void ConstDatabase::ReserveThreadSlots
+(
+    size_t numberOfSlots
+) const {
+    assert(numberOfSlots <= MAX_PSW);
+
+    if (numberOfSlots > MAX_PSW)
+        numberOfSlots = MAX_PSW;
+
+    if ((m_resources != 0) && (numberOfSlots > m_numberOfResources)) {
+        if (!BU_SETJUMP) {
+            while (m_numberOfResources < numberOfSlots) {
+                resource* resp = static_cast<resource*>(bu_calloc(1, sizeof(resource), "BRLCAD::ConstDatabase::ReserveThreadSlots"));
+
+                rt_init_resource(resp, static_cast<int>(m_numberOfResources), m_rtip);
+
+                m_resources[m_numberOfResources] = resp;
+                ++m_numberOfResources;
+            }
+        }
+        else {
+            BU_UNSETJUMP;
+        }
+
+        BU_UNSETJUMP;
+    }
+}
+
+
+size_t ConstDatabase::NumberOfThreadSlots(void) const {
+    return m_numberOfResources;
+}
+
+
+void ConstDatabase::ShootRay
+(
+    const Ray3D& ray,
+    HitCallback& callback,
+    int          flags,
+    size_t       threadSlot
+) const {
+    assert(threadSlot < m_numberOfResources);
+
+    if (!SelectionIsEmpty() && (threadSlot < m_numberOfResources)) {
+        PrepareForRaytracing(m_rtip, 1, m_prepTime);
+
+        application ap;
+        RT_APPLICATION_INIT(&ap);
+
+        ap.a_hit      = HitDo;
+        ap.a_miss     = 0;
+        ap.a_overlap  = 0;
+        ap.a_rt_i     = m_rtip;
+        ap.a_level    = 0;
+        ap.a_onehit   = OneHit(m_rtip, flags);
+        ap.a_user     = flags;
+        ap.a_resource = m_resources[threadSlot];
+        ap.a_return   = 0;
+        ap.a_uptr     = &callback;
+
+        if (flags & WithOverlaps)
+            ap.a_multioverlap = MultioverlapDo;
+        else
+            ap.a_multioverlap = 0;
+
+        VMOVE(ap.a_ray.r_pt, ray.origin.coordinates);
+        VMOVE(ap.a_ray.r_dir, ray.direction.coordinates);
+        VUNITIZE(ap.a_ray.r_dir);
+
+        if (!BU_SETJUMP) {
+            try {
+                rt_shootray(&ap);
+            }
+            catch(...) {
+                BU_UNSETJUMP;
+            }
+        }
+
+        BU_UNSETJUMP;
+    }
+}
+
+
+struct HitBufferData {
+    ConstDatabase::HitBuffer* buffer;
+    int                       fields;
+    int                       flags;
+    size_t                    rayIndex;
+    bool                      shared;    // the buffer is filled by several threads
+    int                       semaphore; // protects buffer->numberOfHits if shared
+};
+
+
+static size_t ReserveHitBufferEntries
+(
+    HitBufferData& data,
+    size_t         numberOfEntries
+) {
+    if (data.shared)
+        bu_semaphore_acquire(data.semaphore);
+
+    size_t ret = data.buffer->numberOfHits;
+    data.buffer->numberOfHits += numberOfEntries;
+
+    if (data.shared)
+        bu_semaphore_release(data.semaphore);
+
+    return ret;
+}
+
+
+static void FillHitBufferEntry
+(
+    application*         ap,
+    const HitBufferData& data,
+    size_t               entry,
+    partition*           part,
+    region*              reg
+) {
+    ConstDatabase::HitBuffer& buffer = *data.buffer;
+
+    if (entry < buffer.capacity) {
+        if (data.fields & ConstDatabase::HitRayIndex)
+            buffer.rayIndex[entry] = data.rayIndex;
+
+        if (data.fields & ConstDatabase::HitDistances) {
+            buffer.distanceIn[entry]  = part->pt_inhit->hit_dist;
+            buffer.distanceOut[entry] = part->pt_outhit->hit_dist;
+        }
+
+        if (data.fields & ConstDatabase::HitRegionIds)
+            buffer.regionId[entry] = reg->reg_regionid;
+
+        // the points don't need the surface normals to be evaluated
+        if (data.fields & ConstDatabase::HitPoints) {
+            VJOIN1(buffer.pointIn + 3 * entry, ap->a_ray.r_pt, part->pt_inhit->hit_dist, ap->a_ray.r_dir);
+            VJOIN1(buffer.pointOut + 3 * entry, ap->a_ray.r_pt, part->pt_outhit->hit_dist, ap->a_ray.r_dir);
+        }
+
+        if (data.fields & ConstDatabase::HitSurfaceNormals) {
+            vect_t normal;
+
+            RT_HIT_NORMAL(normal, part->pt_inhit, part->pt_inseg->seg_stp, 0, part->pt_inflip);
+            VMOVE(buffer.surfaceNormalIn + 3 * entry, normal);
+
+            RT_HIT_NORMAL(normal, part->pt_outhit, part->pt_outseg->seg_stp, 0, part->pt_outflip);
+            VMOVE(buffer.surfaceNormalOut + 3 * entry, normal);
+        }
+    }
+}
+
+
+static int HitBufferDo
+(
+    application* ap,
+    partition*   partitionHead,
+    seg*         UNUSED(segment)
+) {
+    HitBufferData* data            = static_cast<HitBufferData*>(ap->a_uptr);
+    size_t         numberOfEntries = 0;
+
+    for (partition* part = partitionHead->pt_forw;
+         part != partitionHead;
+         part = part->pt_forw) {
+        if (RegionIsHidden(part->pt_regionp))
+            continue;
+
+        ++numberOfEntries;
+
+        if (data->flags & ConstDatabase::StopAfterFirstHit)
+            break;
+    }
+
+    if (numberOfEntries > 0) {
+        size_t     entry = ReserveHitBufferEntries(*data, numberOfEntries);
+        partition* part  = partitionHead->pt_forw;
+
+        for (size_t i = 0; i < numberOfEntries; ++i) {
+            while (RegionIsHidden(part->pt_regionp))
+                part = part->pt_forw;
+
+            FillHitBufferEntry(ap, *data, entry + i, part, part->pt_regionp);
+            part = part->pt_forw;
+        }
+    }
+
+    return (numberOfEntries > 0) ? 1 : 0;
+}
+
+
+static void HitBufferMultioverlapDo
 (
     application* ap,
     partition*   part,
     bu_ptbl*     regiontable,
     partition*   UNUSED(inputHdp)
 ) {
-    ConstDatabase::HitCallback* callback = static_cast<ConstDatabase::HitCallback*>(ap->a_uptr);
-    int&                        ret      = ap->a_return;
+    HitBufferData* data            = static_cast<HitBufferData*>(ap->a_uptr);
+    size_t         numberOfEntries = 0;
+
+    for (size_t i = 0; i < BU_PTBL_LEN(regiontable); ++i) {
+        region* reg = reinterpret_cast<region*>(BU_PTBL_GET(regiontable, i));
+
+        if ((reg != REGION_NULL) && !RegionIsHidden(reg))
+            ++numberOfEntries;
+    }
+
+    if (numberOfEntries > 0) {
+        size_t entry = ReserveHitBufferEntries(*data, numberOfEntries);
 
-    if (ret == 0) {
         for (size_t i = 0; i < BU_PTBL_LEN(regiontable); ++i) {
             region* reg = reinterpret_cast<region*>(BU_PTBL_GET(regiontable, i));
 
-            if (reg == REGION_NULL)
+            if ((reg == REGION_NULL) || RegionIsHidden(reg))
                 continue;
 
             RT_CK_REGION(reg);
 
-            if (!((*callback)(ConstDatabaseHit(ap, part, reg)))) {
-                ret = 1;
-                break;
-            }
+            FillHitBufferEntry(ap, *data, entry, part, reg);
+            ++entry;
         }
     }
 
@@ -827,41 +2400,506 @@ static void MultioverlapDo
 void ConstDatabase::ShootRay
 (
     const Ray3D& ray,
-    HitCallback& callback,
-    int          flags
+    HitBuffer&   buffer,
+    int          fields,
+    int          flags,
+    size_t       threadSlot
 ) const {
-    if (!SelectionIsEmpty()) {
+    assert(threadSlot < m_numberOfResources);
+
+    if (!SelectionIsEmpty() && (threadSlot < m_numberOfResources)) {
+        PrepareForRaytracing(m_rtip, 1, m_prepTime);
+
+        HitBufferData data;
+
+        data.buffer    = &buffer;
+        data.fields    = fields;
+        data.flags     = flags;
+        data.rayIndex  = 0;
+        data.shared    = false;
+        data.semaphore = 0;
+
         application ap;
         RT_APPLICATION_INIT(&ap);
 
-        ap.a_hit      = HitDo;
+        ap.a_hit      = HitBufferDo;
         ap.a_miss     = 0;
         ap.a_overlap  = 0;
         ap.a_rt_i     = m_rtip;
         ap.a_level    = 0;
-        ap.a_onehit   = flags & StopAfterFirstHit;
-        ap.a_resource = m_resp;
+        ap.a_onehit   = OneHit(m_rtip, flags);
+        ap.a_user     = flags;
+        ap.a_resource = m_resources[threadSlot];
         ap.a_return   = 0;
-        ap.a_uptr     = &callback;
+        ap.a_uptr     = &data;
 
         if (flags & WithOverlaps)
+            ap.a_multioverlap = HitBufferMultioverlapDo;
+        else
+            ap.a_multioverlap = 0;
+
+        VMOVE(ap.a_ray.r_pt, ray.origin.coordinates);
+        VMOVE(ap.a_ray.r_dir, ray.direction.coordinates);
+        VUNITIZE(ap.a_ray.r_dir);
+
+        if (!BU_SETJUMP)
+            rt_shootray(&ap);
+
+        BU_UNSETJUMP;
+    }
+}
+
+
+class BatchHitCallbackIntern : public ConstDatabase::HitCallback {
+public:
+    BatchHitCallbackIntern(ConstDatabase::BatchHitCallback* callback) : ConstDatabase::HitCallback(),
+                                                                        m_callback(callback),
+                                                                        m_rayIndex(0) {}
+
+    virtual ~BatchHitCallbackIntern(void) {}
+
+    void         SetRayIndex(size_t rayIndex) {
+        m_rayIndex = rayIndex;
+    }
+
+    virtual bool operator()(const ConstDatabase::Hit& hit) {
+        return (*m_callback)(m_rayIndex, hit);
+    }
+
+private:
+    ConstDatabase::BatchHitCallback* m_callback;
+    size_t                           m_rayIndex;
+};
+
+
+/// output of the visibility queries Occluded() and FirstHitDistance()
+struct VisibilityData {
+    bool*         hits;         // true if the ray hits (within maxDistances)
+    double*       distances;    // distance to the first hit, may be 0
+    const double* maxDistances; // may be 0
+    size_t        rayIndex;
+};
+
+
+static int VisibilityHitDo
+(
+    application* ap,
+    partition*   partitionHead,
+    seg*         UNUSED(segment)
+) {
+    VisibilityData* data = static_cast<VisibilityData*>(ap->a_uptr);
+    int             ret  = 0;
+
+    for (partition* part = partitionHead->pt_forw;
+         part != partitionHead;
+         part = part->pt_forw) {
+        if (RegionIsHidden(part->pt_regionp))
+            continue;
+
+        // the ray may start inside of a region
+        double distance = part->pt_inhit->hit_dist;
+
+        if (distance < 0.)
+            distance = 0.;
+
+        if ((data->maxDistances == 0) || (distance <= data->maxDistances[data->rayIndex]))
+            data->hits[data->rayIndex] = true;
+
+        if (data->distances != 0)
+            data->distances[data->rayIndex] = distance;
+
+        ret = 1;
+        break;
+    }
+
+    return ret;
+}
+
+
+struct ShootRaysData {
+    rt_i*                            rtip;
+    resource**                       resources;
+    const Ray3D*                     rays;
+    size_t                           numberOfRays;
+    ConstDatabase::BatchHitCallback* callback; // either callback
+    ConstDatabase::HitBuffer*        buffer;   // or buffer
+    bool*                            hits;     // or hits is set
+    double*                          distances;
+    const double*                    maxDistances;
+    int                              fields;
+    int                              flags;
+    int                              semaphore;
+    size_t                           nextSlot; // protected by semaphore
+    size_t                           nextRay;  // protected by semaphore
+};
+
+
+// rays fetched by a worker at once, big enough to make the locking negligible
+static const size_t ShootRaysChunkSize = 64;
+
+
+static void InitBatchApplication
+(
+    application&                     ap,
+    rt_i*                            rtip,
+    resource*                        resp,
+    ConstDatabase::BatchHitCallback* callback,
+    BatchHitCallbackIntern&          callbackIntern,
+    HitBufferData&                   hitBufferData,
+    VisibilityData&                  visibilityData,
+    int                              flags
+) {
+    RT_APPLICATION_INIT(&ap);
+
+    ap.a_miss     = 0;
+    ap.a_overlap  = 0;
+    ap.a_rt_i     = rtip;
+    ap.a_level    = 0;
+    ap.a_onehit   = OneHit(rtip, flags);
+    ap.a_user     = flags;
+    ap.a_resource = resp;
+
+    if (callback != 0) {
+        ap.a_hit  = HitDo;
+        ap.a_uptr = &callbackIntern;
+
+        if (flags & ConstDatabase::WithOverlaps)
             ap.a_multioverlap = MultioverlapDo;
         else
             ap.a_multioverlap = 0;
+    }
+    else if (hitBufferData.buffer != 0) {
+        ap.a_hit  = HitBufferDo;
+        ap.a_uptr = &hitBufferData;
+
+        if (flags & ConstDatabase::WithOverlaps)
+            ap.a_multioverlap = HitBufferMultioverlapDo;
+        else
+            ap.a_multioverlap = 0;
+    }
+    else {
+        ap.a_hit          = VisibilityHitDo;
+        ap.a_uptr         = &visibilityData;
+        ap.a_multioverlap = 0;
+    }
+}
+
+
+static void ShootRayRange
+(
+    application&            ap,
+    BatchHitCallbackIntern& callbackIntern,
+    HitBufferData&          hitBufferData,
+    VisibilityData&         visibilityData,
+    const Ray3D*            rays,
+    size_t                  firstRayIndex,
+    size_t                  numberOfRays
+) {
+    for (size_t i = 0; i < numberOfRays; ++i) {
+        const Ray3D& ray = rays[i];
+
+        callbackIntern.SetRayIndex(firstRayIndex + i);
+        hitBufferData.rayIndex  = firstRayIndex + i;
+        visibilityData.rayIndex = firstRayIndex + i;
+        ap.a_return             = 0;
+
+        // librt stops the traversal behind a_ray_length, VisibilityHitDo() checks the distance nevertheless
+        if ((ap.a_hit == VisibilityHitDo) && (visibilityData.maxDistances != 0))
+            ap.a_ray_length = visibilityData.maxDistances[firstRayIndex + i];
 
         VMOVE(ap.a_ray.r_pt, ray.origin.coordinates);
         VMOVE(ap.a_ray.r_dir, ray.direction.coordinates);
         VUNITIZE(ap.a_ray.r_dir);
 
-        if (!BU_SETJUMP) {
-            try {
-                rt_shootray(&ap);
-            }
-            catch(...) {
-                BU_UNSETJUMP;
+        rt_shootray(&ap);
+    }
+}
+
+
+static void ShootRaysWorker
+(
+    int   UNUSED(cpu),
+    void* data
+) {
+    ShootRaysData* shootRaysData = static_cast<ShootRaysData*>(data);
+
+    // the workers pick their resource slot themselves to be independent of the cpu numbering of bu_parallel()
+    bu_semaphore_acquire(shootRaysData->semaphore);
+    size_t threadSlot = shootRaysData->nextSlot++;
+    bu_semaphore_release(shootRaysData->semaphore);
+
+    BatchHitCallbackIntern callbackIntern(shootRaysData->callback);
+    HitBufferData          hitBufferData;
+    VisibilityData         visibilityData;
+    application            ap;
+
+    hitBufferData.buffer    = shootRaysData->buffer;
+    hitBufferData.fields    = shootRaysData->fields;
+    hitBufferData.flags     = shootRaysData->flags;
+    hitBufferData.rayIndex  = 0;
+    hitBufferData.shared    = true;
+    hitBufferData.semaphore = shootRaysData->semaphore;
+
+    visibilityData.hits         = shootRaysData->hits;
+    visibilityData.distances    = shootRaysData->distances;
+    visibilityData.maxDistances = shootRaysData->maxDistances;
+    visibilityData.rayIndex     = 0;
+
+    InitBatchApplication(ap,
+                         shootRaysData->rtip,
+                         shootRaysData->resources[threadSlot],
+                         shootRaysData->callback,
+                         callbackIntern,
+                         hitBufferData,
+                         visibilityData,
+                         shootRaysData->flags);
+
+    if (!BU_SETJUMP) {
+        try {
+            for (;;) {
+                bu_semaphore_acquire(shootRaysData->semaphore);
+                size_t chunkStart       = shootRaysData->nextRay;
+                shootRaysData->nextRay += ShootRaysChunkSize;
+                bu_semaphore_release(shootRaysData->semaphore);
+
+                if (chunkStart >= shootRaysData->numberOfRays)
+                    break;
+
+                size_t chunkEnd = chunkStart + ShootRaysChunkSize;
+
+                if (chunkEnd > shootRaysData->numberOfRays)
+                    chunkEnd = shootRaysData->numberOfRays;
+
+                ShootRayRange(ap, callbackIntern, hitBufferData, visibilityData, shootRaysData->rays + chunkStart, chunkStart, chunkEnd - chunkStart);
             }
         }
+        catch(...) {
+            BU_UNSETJUMP;
+        }
+    }
+
+    BU_UNSETJUMP;
+}
+
+
+void ConstDatabase::ShootRays
+(
+    const Ray3D*      rays,
+    size_t            numberOfRays,
+    BatchHitCallback& callback,
+    int               flags,
+    unsigned int      numberOfThreads
+) const {
+    ShootRaysIntern(rays, numberOfRays, &callback, 0, 0, 0, 0, 0, flags, numberOfThreads);
+}
+
+
+void ConstDatabase::ShootRays
+(
+    const Ray3D* rays,
+    size_t       numberOfRays,
+    HitBuffer&   buffer,
+    int          fields,
+    int          flags,
+    unsigned int numberOfThreads
+) const {
+    ShootRaysIntern(rays, numberOfRays, 0, &buffer, fields, 0, 0, 0, flags, numberOfThreads);
+}
+
+
+void ConstDatabase::ShootRaysIntern
+(
+    const Ray3D*      rays,
+    size_t            numberOfRays,
+    BatchHitCallback* callback,
+    HitBuffer*        buffer,
+    int               fields,
+    bool*             hits,
+    double*           distances,
+    const double*     maxDistances,
+    int               flags,
+    unsigned int      numberOfThreads
+) const {
+    if (!SelectionIsEmpty() && (rays != 0) && (numberOfRays > 0)) {
+        size_t threads = numberOfThreads;
+
+        if (threads == 0)
+            threads = bu_avail_cpus();
+
+        // no more threads than chunks
+        size_t numberOfChunks = (numberOfRays + ShootRaysChunkSize - 1) / ShootRaysChunkSize;
+
+        if (threads > numberOfChunks)
+            threads = numberOfChunks;
+
+        if (threads > MAX_PSW)
+            threads = MAX_PSW;
+
+        if (threads < 1)
+            threads = 1;
+
+        ReserveThreadSlots(threads);
+
+        if (threads > m_numberOfResources)
+            threads = m_numberOfResources;
+
+        PrepareForRaytracing(m_rtip, static_cast<int>(threads), m_prepTime);
+
+        static int semaphore = bu_semaphore_register("BRLCAD_CONSTDATABASE_SHOOTRAYS");
+
+        ShootRaysData shootRaysData;
+
+        shootRaysData.rtip         = m_rtip;
+        shootRaysData.resources    = m_resources;
+        shootRaysData.rays         = rays;
+        shootRaysData.numberOfRays = numberOfRays;
+        shootRaysData.callback     = callback;
+        shootRaysData.buffer       = buffer;
+        shootRaysData.hits         = hits;
+        shootRaysData.distances    = distances;
+        shootRaysData.maxDistances = maxDistances;
+        shootRaysData.fields       = fields;
+        shootRaysData.flags        = flags;
+        shootRaysData.semaphore    = semaphore;
+        shootRaysData.nextSlot     = 0;
+        shootRaysData.nextRay      = 0;
+
+        if (!BU_SETJUMP)
+            bu_parallel(ShootRaysWorker, threads, &shootRaysData);
 
         BU_UNSETJUMP;
     }
 }
+
+
+/// shoots a single visibility ray in the calling thread
+static void ShootVisibilityRay
+(
+    rt_i*           rtip,
+    resource*       resp,
+    const Ray3D&    ray,
+    VisibilityData& visibility,
+    double&         prepTime
+) {
+    PrepareForRaytracing(rtip, 1, prepTime);
+
+    BatchHitCallbackIntern callbackIntern(0);
+    HitBufferData          hitBufferData;
+    application            ap;
+
+    hitBufferData.buffer    = 0;
+    hitBufferData.fields    = 0;
+    hitBufferData.flags     = ConstDatabase::StopAfterFirstHit;
+    hitBufferData.rayIndex  = 0;
+    hitBufferData.shared    = false;
+    hitBufferData.semaphore = 0;
+
+    InitBatchApplication(ap, rtip, resp, 0, callbackIntern, hitBufferData, visibility, ConstDatabase::StopAfterFirstHit);
+
+    if (!BU_SETJUMP) {
+        try {
+            ShootRayRange(ap, callbackIntern, hitBufferData, visibility, &ray, 0, 1);
+        }
+        catch(...) {
+            BU_UNSETJUMP;
+        }
+    }
+
+    BU_UNSETJUMP;
+}
+
+
+bool ConstDatabase::Occluded
+(
+    const Ray3D& ray,
+    double       maxDistance,
+    size_t       threadSlot
+) const {
+    assert(threadSlot < m_numberOfResources);
+
+    bool ret = false;
+
+    if (!SelectionIsEmpty() && (threadSlot < m_numberOfResources)) {
+        VisibilityData visibility;
+
+        visibility.hits         = &ret;
+        visibility.distances    = 0;
+        visibility.maxDistances = &maxDistance;
+        visibility.rayIndex     = 0;
+
+        ShootVisibilityRay(m_rtip, m_resources[threadSlot], ray, visibility, m_prepTime);
+    }
+
+    return ret;
+}
+
+
+bool ConstDatabase::FirstHitDistance
+(
+    const Ray3D& ray,
+    double&      distance,
+    size_t       threadSlot
+) const {
+    assert(threadSlot < m_numberOfResources);
+
+    bool ret = false;
+
+    if (!SelectionIsEmpty() && (threadSlot < m_numberOfResources)) {
+        VisibilityData visibility;
+
+        visibility.hits         = &ret;
+        visibility.distances    = &distance;
+        visibility.maxDistances = 0;
+        visibility.rayIndex     = 0;
+
+        ShootVisibilityRay(m_rtip, m_resources[threadSlot], ray, visibility, m_prepTime);
+    }
+
+    return ret;
+}
+
+
+void ConstDatabase::Occluded
+(
+    const Ray3D*  rays,
+    const double* maxDistances,
+    size_t        numberOfRays,
+    bool*         results,
+    unsigned int  numberOfThreads
+) const {
+    if ((results != 0) && (maxDistances != 0)) {
+        for (size_t i = 0; i < numberOfRays; ++i)
+            results[i] = false;
+
+        ShootRaysIntern(rays, numberOfRays, 0, 0, 0, results, 0, maxDistances, StopAfterFirstHit, numberOfThreads);
+    }
+}
+
+
+void ConstDatabase::FirstHitDistances
+(
+    const Ray3D* rays,
+    size_t       numberOfRays,
+    bool*        hits,
+    double*      distances,
+    unsigned int numberOfThreads
+) const {
+    if ((hits != 0) && (distances != 0)) {
+        for (size_t i = 0; i < numberOfRays; ++i)
+            hits[i] = false;
+
+        ShootRaysIntern(rays, numberOfRays, 0, 0, 0, hits, distances, 0, StopAfterFirstHit, numberOfThreads);
+    }
+}
+
+
+void ConstDatabase::InitResources(void) {
+    for (size_t i = 0; i < m_numberOfResources; ++i)
+        rt_init_resource(m_resources[i], static_cast<int>(i), m_rtip);
+
+    m_selectTime = 0.;
+    m_prepTime   = 0.;
+
+    ClearSelectionList();
+    InvalidatePlotCache(0);
+}
@@ -27,7 +27,7 @@
  *      IABG mbH (Germany)
  */
 
-#include <cassert>
+#include <cstring>
 
 #include "raytrace.h"
 #include "rt/geom.h"
@@ -64,255 +64,357 @@
 using namespace BRLCAD;
 
 
-Database::~Database(void) {
-    if (m_wdbp != 0) {
-        if (!BU_SETJUMP)
-            wdb_close(m_wdbp);
-
-        BU_UNSETJUMP;
-    }
+/// a change of a single object collected in a transaction
+struct DatabaseChange {
+    char*       name;
+    bool        deleted;
+    bu_external external;     ///< the object with its attributes, empty for a deletion
+    int         flags;
+    int         minorType;
+    size_t      nextInBucket; ///< index + 1 of the next change in the same hash bucket, 0: none
+};
+
+
+namespace BRLCAD {
+    /// changes collected between Database::BeginTransaction() and Database::Commit()
+    /** The changes are kept in the order of their first occurrence.
+        They are found by the object name with librt's directory hash function. */
+    struct DatabaseTransaction {
+        DatabaseChange* changes;
+        size_t          numberOfChanges;
+        size_t          capacity;
+        size_t          buckets[RT_DBNHASH]; ///< index + 1 of the first change in the bucket, 0: empty
+    };
 }
 
 
-void Database::SetTitle
+static void ClearChange
 (
-    const char* title
+    DatabaseChange& change
 ) {
-    if (m_wdbp != 0) {
-        if (!BU_SETJUMP)
-            db_update_ident(m_wdbp->dbip, title, m_wdbp->dbip->dbi_base2local);
-        else {
-            BU_UNSETJUMP;
-        }
+    if (change.external.ext_buf != 0)
+        bu_free_external(&change.external);
 
-        BU_UNSETJUMP;
-    }
+    BU_EXTERNAL_INIT(&change.external);
 }
 
 
-bool Database::Add
+/// returns the change of the object \a name, 0 if there is none
+static DatabaseChange* FindChange
 (
-    const Object& object
+    DatabaseTransaction& transaction,
+    const char*          name
 ) {
-    bool ret = false;
+    DatabaseChange* ret = 0;
 
-    if (object.IsValid() && (m_wdbp != 0)) {
-        if (!BU_SETJUMP) {
-            int   id         = ID_NULL;
-            void* rtInternal = 0;
+    for (size_t i = transaction.buckets[db_dirhash(name)]; i != 0; i = transaction.changes[i - 1].nextInBucket) {
+        if (strcmp(transaction.changes[i - 1].name, name) == 0) {
+            ret = transaction.changes + i - 1;
+            break;
+        }
+    }
 
-            if (object.Type() == Torus::ClassName()) {
-                id = ID_TOR; // 1
+    return ret;
+}
 
-                const Torus* torus = dynamic_cast<const Torus*>(&object);
 
-                assert(torus != 0);
+/// returns the change of the object \a name, a new one if there is none yet
+static DatabaseChange& GetChange
+(
+    DatabaseTransaction& transaction,
+    const char*          name
+) {
+    DatabaseChange* found = FindChange(transaction, name);
 
-                BU_GET(rtInternal, rt_tor_internal);
-                memcpy(rtInternal, torus->Internal(), sizeof(rt_tor_internal));
-            }
-            else if (object.Type() == Cone::ClassName()) {
-                id = ID_TGC; // 2
+    if (found != 0)
+        return *found;
 
-                const Cone* cone = dynamic_cast<const Cone*>(&object);
+    int bucket = db_dirhash(name);
 
-                assert(cone != 0);
+    if (transaction.numberOfChanges == transaction.capacity) {
+        size_t newCapacity = (transaction.capacity > 0) ? 2 * transaction.capacity : 64;
 
-                BU_GET(rtInternal, rt_tgc_internal);
-                memcpy(rtInternal, cone->Internal(), sizeof(rt_tgc_internal));
-            }
-            else if (object.Type() == Ellipsoid::ClassName()) {
-                id = ID_ELL; // 3
+        transaction.changes  = static_cast<DatabaseChange*>(bu_realloc(transaction.changes, newCapacity * sizeof(DatabaseChange), "BRLCAD::Database::GetChange::changes"));
+        transaction.capacity = newCapacity;
+    }
 
-                const Ellipsoid* ellipsoid = dynamic_cast<const Ellipsoid*>(&object);
+    DatabaseChange& ret = transaction.changes[transaction.numberOfChanges];
 
-                assert(ellipsoid != 0);
+    ret.name         = bu_strdup(name);
+    ret.deleted      = false;
+    ret.flags        = 0;
+    ret.minorType    = 0;
+    ret.nextInBucket = transaction.buckets[bucket];
+    BU_EXTERNAL_INIT(&ret.external);
 
-                BU_GET(rtInternal, rt_ell_internal);
-                memcpy(rtInternal, ellipsoid->Internal(), sizeof(rt_ell_internal));
-            }
-            else if (object.Type() == Arb8::ClassName()) {
-                id = ID_ARB8; // 4
+    ++transaction.numberOfChanges;
+    transaction.buckets[bucket] = transaction.numberOfChanges;
 
-                const Arb8* arb8 = dynamic_cast<const Arb8*>(&object);
+    return ret;
+}
 
-                assert(arb8 != 0);
 
-                BU_GET(rtInternal, rt_arb_internal);
-                memcpy(rtInternal, arb8->Internal(), sizeof(rt_arb_internal));
-            }
-            else if (object.Type() == Halfspace::ClassName()) {
-                id = ID_HALF; // 6
+/// converts the object with its attributes to its external form and puts it into the transaction
+static bool StageObject
+(
+    DatabaseTransaction&  transaction,
+    const char*           name,
+    const rt_db_internal& intern,
+    db_i*                 dbip,
+    resource*             resp
+) {
+    bool        ret = false;
+    bu_external ext;
 
-                const Halfspace* halfspace = dynamic_cast<const Halfspace*>(&object);
+    BU_EXTERNAL_INIT(&ext);
 
-                assert(halfspace != 0);
+    if (rt_db_cvt_to_external5(&ext, name, &intern, 1., dbip, resp, intern.idb_major_type) == 0) {
+        DatabaseChange& change = GetChange(transaction, name);
 
-                BU_GET(rtInternal, rt_half_internal);
-                memcpy(rtInternal, halfspace->Internal(), sizeof(rt_half_internal));
-            }
-            else if (object.Type() == Sphere::ClassName()) {
-                id = ID_SPH; // 10
+        ClearChange(change);
+        change.deleted   = false;
+        change.external  = ext;
+        change.flags     = db_flags_internal(&intern);
+        change.minorType = intern.idb_type;
 
-                const Sphere* sphere = dynamic_cast<const Sphere*>(&object);
+        ret = true;
+    }
+    else if (ext.ext_buf != 0)
+        bu_free_external(&ext);
 
-                assert(sphere != 0);
+    return ret;
+}
 
-                BU_GET(rtInternal, rt_ell_internal);
-                memcpy(rtInternal, sphere->Internal(), sizeof(rt_ell_internal));
-            }
-            else if (object.Type() == NonManifoldGeometry::ClassName()) {
-                id = ID_NMG; // 11
 
-                const NonManifoldGeometry* nmg = dynamic_cast<const NonManifoldGeometry*>(&object);
+static void StageDeletion
+(
+    DatabaseTransaction& transaction,
+    const char*          name
+) {
+    DatabaseChange& change = GetChange(transaction, name);
 
-                assert(nmg != 0);
+    ClearChange(change);
+    change.deleted = true;
+}
 
-                rtInternal = nmg_clone_model(nmg->Internal());
-            }
-            else if (object.Type() == Pipe::ClassName()) {
-                id = ID_PIPE; // 15
 
-                const Pipe* pipe = dynamic_cast<const Pipe*>(&object);
+static void FreeTransaction
+(
+    DatabaseTransaction* transaction
+) {
+    for (size_t i = 0; i < transaction->numberOfChanges; ++i) {
+        ClearChange(transaction->changes[i]);
+        bu_free(transaction->changes[i].name, "BRLCAD::Database::FreeTransaction::name");
+    }
 
-                assert(pipe != 0);
+    if (transaction->changes != 0)
+        bu_free(transaction->changes, "BRLCAD::Database::FreeTransaction::changes");
 
-                rtInternal = ClonePipeInternal(*(pipe->Internal()));
-            }
-            else if (object.Type() == Particle::ClassName()) {
-                id = ID_PARTICLE; // 16
+    bu_free(transaction, "BRLCAD::Database::FreeTransaction::transaction");
+}
 
-                const Particle* particle = dynamic_cast<const Particle*>(&object);
 
-                assert(particle != 0);
+Database::~Database(void) {
+    Rollback();
 
-                BU_GET(rtInternal, rt_part_internal);
-                memcpy(rtInternal, particle->Internal(), sizeof(rt_part_internal));
-            }
-            else if (object.Type() == ParabolicCylinder::ClassName()) {
-                id = ID_RPC; // 17
+    if (m_wdbp != 0) {
+        if (!BU_SETJUMP)
+            wdb_close(m_wdbp);
 
-                const ParabolicCylinder* parabolicCylinder = dynamic_cast<const ParabolicCylinder*>(&object);
+        BU_UNSETJUMP;
+    }
+}
 
-                assert(parabolicCylinder != 0);
 
-                BU_GET(rtInternal, rt_rpc_internal);
-                memcpy(rtInternal, parabolicCylinder->Internal(), sizeof(rt_rpc_internal));
-            }
-            else if (object.Type() == HyperbolicCylinder::ClassName()) {
-                id = ID_RHC; // 18
+void Database::SetTitle
+(
+    const char* title
+) {
+    if (m_wdbp != 0) {
+        if (!BU_SETJUMP)
+            db_update_ident(m_wdbp->dbip, title, m_wdbp->dbip->dbi_base2local);
+        else {
+            BU_UNSETJUMP;
+        }
 
-                const HyperbolicCylinder* hyperbolicCylinder = dynamic_cast<const HyperbolicCylinder*>(&object);
+        BU_UNSETJUMP;
+    }
+}
 
-                assert(hyperbolicCylinder != 0);
 
-                BU_GET(rtInternal, rt_rhc_internal);
-                memcpy(rtInternal, hyperbolicCylinder->Internal(), sizeof(rt_rhc_internal));
-            }
-            else if (object.Type() == Paraboloid::ClassName()) {
-                id = ID_EPA; // 19
+static void* CopyInternal
+(
+    const model* internal,
+    resource*
+) {
+    return nmg_clone_model(internal);
+}
 
-                const Paraboloid* paraboloid = dynamic_cast<const Paraboloid*>(&object);
 
-                assert(paraboloid != 0);
+static void* CopyInternal
+(
+    const rt_pipe_internal* internal,
+    resource*
+) {
+    return ClonePipeInternal(*internal);
+}
 
-                BU_GET(rtInternal, rt_epa_internal);
-                memcpy(rtInternal, paraboloid->Internal(), sizeof(rt_epa_internal));
-            }
-            else if (object.Type() == Hyperboloid::ClassName()) {
-                id = ID_EHY; // 20
 
-                const Hyperboloid* hyperboloid = dynamic_cast<const Hyperboloid*>(&object);
+static void* CopyInternal
+(
+    const rt_sketch_internal* internal,
+    resource*
+) {
+    return rt_copy_sketch(internal);
+}
 
-                assert(hyperboloid != 0);
 
-                BU_GET(rtInternal, rt_ehy_internal);
-                memcpy(rtInternal, hyperboloid->Internal(), sizeof(rt_ehy_internal));
-            }
-            else if (object.Type() == EllipticalTorus::ClassName()) {
-                id = ID_ETO; // 21
+static void* CopyInternal
+(
+    const rt_bot_internal* internal,
+    resource*
+) {
+    rt_bot_internal* ret = CloneBotInternal(*internal);
 
-                const EllipticalTorus* ellipticalTorus = dynamic_cast<const EllipticalTorus*>(&object);
+    CleanUpBotInternal(*ret);
 
-                assert(ellipticalTorus != 0);
+    return ret;
+}
 
-                BU_GET(rtInternal, rt_eto_internal);
-                memcpy(rtInternal, ellipticalTorus->Internal(), sizeof(rt_eto_internal));
-            }
-            else if (object.Type() == Sketch::ClassName()) {
-                id = ID_SKETCH; // 26
 
-                const Sketch* sketch = dynamic_cast<const Sketch*>(&object);
+static void* CopyInternal
+(
+    const rt_comb_internal* internal,
+    resource*               resp
+) {
+    rt_comb_internal* ret;
 
-                assert(sketch != 0);
+    BU_GET(ret, rt_comb_internal);
+    memcpy(ret, internal, sizeof(rt_comb_internal));
 
-                rtInternal = rt_copy_sketch(sketch->Internal());
-            }
-            else if (object.Type() == BagOfTriangles::ClassName()) {
-                id = ID_BOT; // 30
+    if (internal->tree != 0)
+        ret->tree = db_dup_subtree(internal->tree, resp);
 
-                const BagOfTriangles* bagOfTriangles = dynamic_cast<const BagOfTriangles*>(&object);
+    bu_vls_init(&ret->shader);
+    bu_vls_strcpy(&ret->shader, bu_vls_addr(&internal->shader));
+    bu_vls_init(&ret->material);
+    bu_vls_strcpy(&ret->material, bu_vls_addr(&internal->material));
 
-                assert(bagOfTriangles != 0);
+    return ret;
+}
 
-                rt_bot_internal* bot = CloneBotInternal(*(bagOfTriangles->Internal()));
-                CleanUpBotInternal(*bot);
 
-                rtInternal = bot;
-            }
-            else if (object.Type() == Combination::ClassName()) {
-                id = ID_COMBINATION;  // 31
+/// the plain old data internals of the solids
+template<class InternalType>
+static void* CopyInternal
+(
+    const InternalType* internal,
+    resource*
+) {
+    InternalType* ret;
+
+    BU_GET(ret, InternalType);
+    memcpy(ret, internal, sizeof(InternalType));
+
+    return ret;
+}
 
-                const Combination* combination = dynamic_cast<const Combination*>(&object);
 
-                assert(combination != 0);
+template<class T>
+void* Database::CloneInternal
+(
+    const Object& object
+) {
+    const T& typedObject = static_cast<const T&>(object);
 
-                const rt_comb_internal* internalFrom = combination->Internal();
+    return CopyInternal(typedObject.Internal(), object.m_resp);
+}
 
-                BU_GET(rtInternal, rt_comb_internal);
-                memcpy(rtInternal, internalFrom, sizeof(rt_comb_internal));
 
-                rt_comb_internal* internalTo = static_cast<rt_comb_internal*>(rtInternal);
+bool Database::Add
+(
+    const Object& object
+) {
+    struct ObjectType {
+        const char* (*className)(void);
+        int           id;
+        void*       (*cloneInternal)(const Object&);
+    };
+
+    // the wrappers which can be written to the database, Object::Type() returns their ClassName()
+    static const ObjectType ObjectTypes[] = {
+        {Torus::ClassName,               ID_TOR,         CloneInternal<Torus>},
+        {Cone::ClassName,                ID_TGC,         CloneInternal<Cone>},
+        {Ellipsoid::ClassName,           ID_ELL,         CloneInternal<Ellipsoid>},
+        {Arb8::ClassName,                ID_ARB8,        CloneInternal<Arb8>},
+        {Halfspace::ClassName,           ID_HALF,        CloneInternal<Halfspace>},
+        {Sphere::ClassName,              ID_SPH,         CloneInternal<Sphere>},
+        {NonManifoldGeometry::ClassName, ID_NMG,         CloneInternal<NonManifoldGeometry>},
+        {Pipe::ClassName,                ID_PIPE,        CloneInternal<Pipe>},
+        {Particle::ClassName,            ID_PARTICLE,    CloneInternal<Particle>},
+        {ParabolicCylinder::ClassName,   ID_RPC,         CloneInternal<ParabolicCylinder>},
+        {HyperbolicCylinder::ClassName,  ID_RHC,         CloneInternal<HyperbolicCylinder>},
+        {Paraboloid::ClassName,          ID_EPA,         CloneInternal<Paraboloid>},
+        {Hyperboloid::ClassName,         ID_EHY,         CloneInternal<Hyperboloid>},
+        {EllipticalTorus::ClassName,     ID_ETO,         CloneInternal<EllipticalTorus>},
+        {Sketch::ClassName,              ID_SKETCH,      CloneInternal<Sketch>},
+        {BagOfTriangles::ClassName,      ID_BOT,         CloneInternal<BagOfTriangles>},
+        {Combination::ClassName,         ID_COMBINATION, CloneInternal<Combination>}
+    };
+    static const size_t NumberOfObjectTypes = sizeof(ObjectTypes) / sizeof(ObjectTypes[0]);
 
-                if (internalFrom->tree != 0)
-                    internalTo->tree = db_dup_subtree(internalFrom->tree, object.m_resp);
+    bool ret = false;
 
-                bu_vls_init(&internalTo->shader);
-                bu_vls_strcpy(&internalTo->shader, bu_vls_addr(&internalFrom->shader));
-                bu_vls_init(&internalTo->material);
-                bu_vls_strcpy(&internalTo->material, bu_vls_addr(&internalFrom->material));
+    if (object.IsValid() && (m_wdbp != 0)) {
+        if (!BU_SETJUMP) {
+            int         id         = ID_NULL;
+            void*       rtInternal = 0;
+            const char* type       = object.Type();
+
+            for (size_t i = 0; i < NumberOfObjectTypes; ++i) {
+                if (type == ObjectTypes[i].className()) {
+                    id         = ObjectTypes[i].id;
+                    rtInternal = ObjectTypes[i].cloneInternal(object);
+                    break;
+                }
             }
 
             const char* objectName = object.Name();
 
             if ((id != ID_NULL) && (objectName != 0) && (strlen(objectName) > 0)) {
-                ret = (wdb_export(m_wdbp, objectName, rtInternal, id, 1.) == 0);
+                // the geometry and the attributes go into one record
+                rt_db_internal intern;
 
-                // copy attributes
-                if (ret) {
-                    const bu_attribute_value_set* origAvs = object.GetAvs();
+                RT_DB_INTERNAL_INIT(&intern);
+                intern.idb_major_type = DB5_MAJORTYPE_BRLCAD;
+                intern.idb_type       = id;
+                intern.idb_meth       = &OBJ[id];
+                intern.idb_ptr        = rtInternal;
 
-                    if ((origAvs != 0) && (origAvs->count > 0)) {
-                        directory* pDir = db_lookup(m_rtip->rti_dbip, object.Name(), LOOKUP_NOISE);
+                const bu_attribute_value_set* origAvs = object.GetAvs();
 
-                        assert(pDir != 0);
+                if ((origAvs != 0) && (origAvs->count > 0)) {
+                    bu_avs_init(&intern.idb_avs, origAvs->count, "BRLCAD::Database::Add");
 
-                        if (pDir != 0) {
-                            bu_attribute_value_set avs;
-                            bu_avs_init(&avs, origAvs->count, "BRLCAD::Database::Add");
+                    for (size_t i = 0; i < origAvs->count; ++i)
+                        bu_avs_add_nonunique(&intern.idb_avs, origAvs->avp[i].name, origAvs->avp[i].value);
+                }
 
-                            for (size_t i = 0; i < origAvs->count; ++i)
-                                bu_avs_add_nonunique(&avs, origAvs->avp[i].name, origAvs->avp[i].value);
+                if (m_transaction != 0) {
+                    ret = StageObject(*m_transaction, objectName, intern, m_wdbp->dbip, m_resp);
 
-                            ret = (db5_update_attributes(pDir, &avs, m_rtip->rti_dbip) == 0);
-                        }
-                    }
+                    rt_db_free_internal(&intern);
                 }
-
+                else // frees intern
+                    ret = (wdb_put_internal(m_wdbp, objectName, &intern, 1.) == 0);
             }
         }
 
         BU_UNSETJUMP;
+
+        // the new object may be a formerly missing member of a cached tree
+        if (ret && (m_transaction == 0))
+            InvalidatePlotCache(0);
     }
 
     return ret;
@@ -323,11 +425,19 @@ void Database::Delete
 (
     const char* objectName
 ) {
-    if (m_wdbp != 0) {
+    if ((m_wdbp != 0) && (m_transaction != 0)) {
+        if (!BU_SETJUMP)
+            StageDeletion(*m_transaction, objectName);
+
+        BU_UNSETJUMP;
+    }
+    else if (m_wdbp != 0) {
         if (!BU_SETJUMP) {
             directory* pDir = db_lookup(m_rtip->rti_dbip, objectName, LOOKUP_NOISE);
 
             if (pDir != RT_DIR_NULL) {
+                InvalidatePlotCache(pDir);
+
                 if (db_delete(m_wdbp->dbip, pDir) == 0)
                     db_dirdelete(m_wdbp->dbip, pDir);
             }
@@ -345,9 +455,11 @@ bool Database::Get
 ) {
     class ObjectCallbackIntern : public ConstDatabase::ObjectCallback {
     public:
-        ObjectCallbackIntern(Database::ObjectCallback& cb) : ConstDatabase::ObjectCallback(),
-                                                             m_callback(cb),
-                                                             m_okay(true) {}
+        ObjectCallbackIntern(Database::ObjectCallback& cb,
+                             DatabaseTransaction*      transaction) : ConstDatabase::ObjectCallback(),
+                                                                    m_callback(cb),
+                                                                    m_transaction(transaction),
+                                                                    m_okay(false) {}
 
         virtual ~ObjectCallbackIntern(void) {}
 
@@ -358,32 +470,105 @@ bool Database::Get
         virtual void operator()(const Object& object) {
             Object& objectIntern = const_cast<Object&>(object);
 
+            // db_rename() would change the database immediately
+            if (m_transaction != 0)
+                objectIntern.m_fixedName = true;
+
             m_callback(objectIntern);
 
             if (objectIntern.IsValid()) {
                 bool success = false;
 
-                if (!BU_SETJUMP)
-                    success = (rt_db_put_internal(objectIntern.m_pDir,
-                                                  objectIntern.m_dbip,
-                                                  objectIntern.m_ip,
-                                                  objectIntern.m_resp) == 0);
+                // the vertices left unused by BagOfTriangles::DeleteFace() aren't written, like in Add()
+                if (objectIntern.Type() == BagOfTriangles::ClassName())
+                    static_cast<BagOfTriangles&>(objectIntern).Compact();
+
+                if (!BU_SETJUMP) {
+                    if (m_transaction != 0)
+                        success = StageObject(*m_transaction,
+                                              objectIntern.m_pDir->d_namep,
+                                              *objectIntern.m_ip,
+                                              objectIntern.m_dbip,
+                                              objectIntern.m_resp);
+                    else
+                        success = (rt_db_put_internal(objectIntern.m_pDir,
+                                                      objectIntern.m_dbip,
+                                                      objectIntern.m_ip,
+                                                      objectIntern.m_resp) == 0);
+                }
 
                 BU_UNSETJUMP;
 
-                if (!success)
-                    m_okay = false;
+                m_okay = success;
             }
-            else
-                m_okay = false;
         }
 
     private:
         Database::ObjectCallback& m_callback;
+        DatabaseTransaction*      m_transaction;
         bool                      m_okay;
-    } callbackIntern(callback);
+    } callbackIntern(callback, m_transaction);
 
-    ConstDatabase::Get(objectName, callbackIntern);
+    DatabaseChange* change = 0;
+
+    if ((m_transaction != 0) && (objectName != 0))
+        change = FindChange(*m_transaction, objectName);
+
+    if (change == 0)
+        ConstDatabase::Get(objectName, callbackIntern);
+    else if (!change->deleted) {
+        // the object was already changed or added in this transaction, continue with its staged version
+        if (!BU_SETJUMP) {
+            db_i*          dbip = m_rtip->rti_dbip;
+            rt_db_internal intern;
+
+            RT_DB_INTERNAL_INIT(&intern);
+
+            int id = rt_db_external5_to_internal5(&intern, &change->external, change->name, dbip, 0, m_resp);
+
+            if (id >= 0) {
+                directory* pDir = db_lookup(dbip, change->name, LOOKUP_QUIET);
+                directory  stagedDir;
+
+                if (pDir == RT_DIR_NULL) {
+                    // added in this transaction: a directory entry which isn't part of the database
+                    memset(&stagedDir, 0, sizeof(directory));
+                    stagedDir.d_magic      = RT_DIR_MAGIC;
+                    stagedDir.d_namep      = change->name;
+                    stagedDir.d_addr       = RT_DIR_PHONY_ADDR;
+                    stagedDir.d_flags      = change->flags;
+                    stagedDir.d_major_type = DB5_MAJORTYPE_BRLCAD;
+                    stagedDir.d_minor_type = change->minorType;
+                    pDir                   = &stagedDir;
+                }
+
+                try {
+                    HandOverObject(pDir, intern, id, callbackIntern);
+                }
+                catch(...) {
+                    BU_UNSETJUMP;
+                    rt_db_free_internal(&intern);
+                    throw;
+                }
+            }
+
+            rt_db_free_internal(&intern);
+        }
+
+        BU_UNSETJUMP;
+    }
+
+    // the callback may have changed the object, in a transaction this happens with Commit()
+    if ((m_rtip != 0) && (m_transaction == 0)) {
+        if (!BU_SETJUMP) {
+            directory* pDir = db_lookup(m_rtip->rti_dbip, objectName, LOOKUP_QUIET);
+
+            if (pDir != RT_DIR_NULL)
+                InvalidatePlotCache(pDir);
+        }
+
+        BU_UNSETJUMP;
+    }
 
     return callbackIntern.Okay();
 }
@@ -412,4 +597,101 @@ bool Database::Set
 }
 
 
-Database::Database(void) : ConstDatabase(), m_wdbp(0) {}
+void Database::BeginTransaction(void) {
+    // the changes are collected in the external format of version 5
+    if ((m_wdbp != 0) && (m_transaction == 0) && (db_version(m_wdbp->dbip) >= 5)) {
+        if (!BU_SETJUMP)
+            m_transaction = static_cast<DatabaseTransaction*>(bu_calloc(1, sizeof(DatabaseTransaction), "BRLCAD::Database::BeginTransaction::m_transaction"));
+
+        BU_UNSETJUMP;
+    }
+}
+
+
+bool Database::Commit(void) {
+    bool ret = true;
+
+    if (m_transaction != 0) {
+        DatabaseTransaction* transaction = m_transaction;
+        bool                 newObjects  = false;
+
+        m_transaction = 0;
+
+        if (m_wdbp != 0) {
+            db_i* dbip = m_wdbp->dbip;
+
+            for (size_t i = 0; i < transaction->numberOfChanges; ++i) {
+                DatabaseChange& change = transaction->changes[i];
+
+                if (!BU_SETJUMP) {
+                    directory* pDir = db_lookup(dbip, change.name, LOOKUP_QUIET);
+
+                    if (change.deleted) {
+                        if (pDir != RT_DIR_NULL) {
+                            InvalidatePlotCache(pDir);
+
+                            if (db_delete(dbip, pDir) == 0)
+                                db_dirdelete(dbip, pDir);
+                            else
+                                ret = false;
+                        }
+                    }
+                    else {
+                        if (pDir == RT_DIR_NULL)
+                            newObjects = true;
+                        else
+                            InvalidatePlotCache(pDir);
+
+                        // works for in-memory databases too, an in-memory database takes the buffer over
+                        if (wdb_export_external(m_wdbp, &change.external, change.name, change.flags, change.minorType) < 0)
+                            ret = false;
+                        else {
+                            pDir = db_lookup(dbip, change.name, LOOKUP_QUIET);
+
+                            // the object may have changed its type in the transaction
+                            if (pDir != RT_DIR_NULL) {
+                                pDir->d_flags      = (pDir->d_flags & ~(RT_DIR_SOLID | RT_DIR_COMB | RT_DIR_REGION)) | change.flags;
+                                pDir->d_minor_type = change.minorType;
+                            }
+                            else
+                                ret = false;
+                        }
+                    }
+                }
+                else {
+                    BU_UNSETJUMP;
+                    ret = false;
+                }
+
+                BU_UNSETJUMP;
+
+                // release the memory as early as possible
+                ClearChange(change);
+            }
+        }
+
+        // a new object may be a formerly missing member of a cached tree
+        if (newObjects)
+            InvalidatePlotCache(0);
+
+        FreeTransaction(transaction);
+    }
+
+    return ret;
+}
+
+
+void Database::Rollback(void) {
+    if (m_transaction != 0) {
+        FreeTransaction(m_transaction);
+        m_transaction = 0;
+    }
+}
+
+
+bool Database::InTransaction(void) const {
+    return m_transaction != 0;
+}
+
+
+Database::Database(void) : ConstDatabase(), m_wdbp(0), m_transaction(0) {}
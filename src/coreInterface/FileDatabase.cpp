@@ -49,6 +49,9 @@ bool FileDatabase::Load
     bool ret = false;
 
     if (m_resp != 0) {
+        // pending changes belong to the old database
+        Rollback();
+
         if (m_rtip != 0) {
             if (!BU_SETJUMP)
                 rt_free_rti(m_rtip);
@@ -84,7 +87,7 @@ bool FileDatabase::Load
                     m_rtip = rt_new_rti(m_wdbp->dbip);          // clones dbip
 
                     if (m_rtip != 0) {
-                        rt_init_resource(m_resp, 0, m_rtip);
+                        InitResources();
                         ret = true;
                     }
                     else {
@@ -38,6 +38,152 @@
 using namespace BRLCAD;
 
 
+// objects fetched by a worker at once, big enough to make the locking negligible
+static const size_t CopyObjectsChunkSize = 256;
+
+// below this number of objects the copy runs on a single thread
+static const size_t ParallelCopyThreshold = 4 * CopyObjectsChunkSize;
+
+
+struct CopyObjectsData {
+    db_i*       source;
+    db_i*       target;
+    directory** sourceDirs;
+    directory** targetDirs;
+    size_t      numberOfObjects;
+    int         semaphore;
+    size_t      nextObject;
+    bool        failed;
+};
+
+
+static void CopyObjectsWorker
+(
+    int   UNUSED(cpu),
+    void* data
+) {
+    CopyObjectsData* copyData = static_cast<CopyObjectsData*>(data);
+
+    if (!BU_SETJUMP) {
+        for (;;) {
+            bu_semaphore_acquire(copyData->semaphore);
+            size_t chunkStart     = copyData->nextObject;
+            copyData->nextObject += CopyObjectsChunkSize;
+            bu_semaphore_release(copyData->semaphore);
+
+            if (chunkStart >= copyData->numberOfObjects)
+                break;
+
+            size_t chunkEnd = chunkStart + CopyObjectsChunkSize;
+
+            if (chunkEnd > copyData->numberOfObjects)
+                chunkEnd = copyData->numberOfObjects;
+
+            for (size_t i = chunkStart; i < chunkEnd; ++i) {
+                bu_external ext;
+
+                // a mapped file is read with a single memcpy
+                if (db_get_external(&ext, copyData->sourceDirs[i], copyData->source) < 0) {
+                    bu_semaphore_acquire(copyData->semaphore);
+                    copyData->failed = true;
+                    bu_semaphore_release(copyData->semaphore);
+                }
+                else // takes over the buffer of ext, touches nothing but the directory entry
+                    db_inmem(copyData->targetDirs[i], &ext, copyData->sourceDirs[i]->d_flags, copyData->target);
+            }
+        }
+    }
+    else {
+        BU_UNSETJUMP;
+
+        bu_semaphore_acquire(copyData->semaphore);
+        copyData->failed = true;
+        bu_semaphore_release(copyData->semaphore);
+    }
+
+    BU_UNSETJUMP;
+}
+
+
+/// copies the objects of \a source into the in-memory database \a target
+/** The objects are taken over with their external representation,
+    i.e. with one memcpy each and without decoding and re-encoding them like db_dump() does.
+    The directory entries are created first on one thread, the objects are copied in parallel then.
+    Only database files of version 4 go the db_dump() way because their objects have to be converted. */
+static bool CopyObjects
+(
+    rt_wdb* target,
+    db_i*   source
+) {
+    bool ret = true;
+
+    if (db_version(source) < 5)
+        ret = (db_dump(target, source) == 0);
+    else {
+        CopyObjectsData copyData = {source, target->dbip, 0, 0, 0, 0, 0, false};
+        size_t          numberOfSourceObjects = 0;
+
+        for (int i = 0; i < RT_DBNHASH; ++i) {
+            for (directory* pDir = source->dbi_Head[i]; pDir != RT_DIR_NULL; pDir = pDir->d_forw)
+                ++numberOfSourceObjects;
+        }
+
+        if (numberOfSourceObjects > 0) {
+            copyData.sourceDirs = static_cast<directory**>(bu_malloc(numberOfSourceObjects * sizeof(directory*), "BRLCAD::MemoryDatabase::CopyObjects::sourceDirs"));
+            copyData.targetDirs = static_cast<directory**>(bu_malloc(numberOfSourceObjects * sizeof(directory*), "BRLCAD::MemoryDatabase::CopyObjects::targetDirs"));
+
+            // the directory hash table is filled serially
+            for (int i = 0; i < RT_DBNHASH; ++i) {
+                for (directory* pDir = source->dbi_Head[i]; pDir != RT_DIR_NULL; pDir = pDir->d_forw) {
+                    // e.g. _GLOBAL exists already
+                    directory* newDir = db_lookup(copyData.target, pDir->d_namep, LOOKUP_QUIET);
+
+                    if (newDir == RT_DIR_NULL)
+                        newDir = db_diradd(copyData.target, pDir->d_namep, RT_DIR_PHONY_ADDR, 0, pDir->d_flags, &pDir->d_minor_type);
+
+                    if (newDir != RT_DIR_NULL) {
+                        newDir->d_major_type = pDir->d_major_type;
+                        newDir->d_minor_type = pDir->d_minor_type;
+
+                        copyData.sourceDirs[copyData.numberOfObjects] = pDir;
+                        copyData.targetDirs[copyData.numberOfObjects] = newDir;
+                        ++copyData.numberOfObjects;
+                    }
+                    else
+                        ret = false;
+                }
+            }
+
+            size_t threads = 1;
+
+            if (copyData.numberOfObjects >= ParallelCopyThreshold) {
+                threads = bu_avail_cpus();
+
+                if (threads > MAX_PSW)
+                    threads = MAX_PSW;
+
+                if (threads < 1)
+                    threads = 1;
+            }
+
+            static int semaphore = bu_semaphore_register("BRLCAD_MEMORYDATABASE_COPYOBJECTS");
+
+            copyData.semaphore = semaphore;
+
+            bu_parallel(CopyObjectsWorker, threads, &copyData);
+
+            if (copyData.failed)
+                ret = false;
+
+            bu_free(copyData.targetDirs, "BRLCAD::MemoryDatabase::CopyObjects::targetDirs");
+            bu_free(copyData.sourceDirs, "BRLCAD::MemoryDatabase::CopyObjects::sourceDirs");
+        }
+    }
+
+    return ret;
+}
+
+
 MemoryDatabase::MemoryDatabase(void) : Database() {
     db_i* dbip = 0;
 
@@ -50,7 +196,7 @@ MemoryDatabase::MemoryDatabase(void) : Database() {
 
     if (!BU_SETJUMP) {
         m_rtip = rt_new_rti(dbip); // clones dbip
-        rt_init_resource(m_resp, 0, m_rtip);
+        InitResources();
     }
     else {
         BU_UNSETJUMP;
@@ -74,10 +220,18 @@ bool MemoryDatabase::Load
     bool ret = false;
 
     if (!BU_SETJUMP) {
-        rt_i* source = rt_dirbuild(fileName, 0, 0);
+        // the file is mapped read-only, no rt_i is needed
+        db_i* source = db_open(fileName, "r");
 
-        if (source != 0) {
+        if ((source != DBI_NULL) && (db_dirbuild(source) != 0)) {
+            db_close(source);
+            source = DBI_NULL;
+        }
+
+        if (source != DBI_NULL) {
             // free old database
+            Rollback();
+
             if (m_wdbp != 0) {
                 wdb_close(m_wdbp);
                 m_wdbp = 0;
@@ -93,16 +247,16 @@ bool MemoryDatabase::Load
             RT_CK_DBI(dbip);
 
             m_rtip = rt_new_rti(dbip);
-            rt_init_resource(m_resp, 0, m_rtip);
+            InitResources();
             m_wdbp = dbip->dbi_wdbp_inmem;
 
             // fill database
-            ret = (db_dump(m_wdbp, source->rti_dbip) == 0);
+            ret = CopyObjects(m_wdbp, source);
 
             assert(m_wdbp->dbip == m_rtip->rti_dbip);
-            db_update_ident(m_wdbp->dbip, source->rti_dbip->dbi_title, source->rti_dbip->dbi_base2local);
+            db_update_ident(m_wdbp->dbip, source->dbi_title, source->dbi_base2local);
 
-            rt_free_rti(source);
+            db_close(source);
         }
     }
 
@@ -124,6 +278,8 @@ bool MemoryDatabase::Load
 
         if (source != 0) {
             // free old database
+            Rollback();
+
             if (m_wdbp != 0) {
                 wdb_close(m_wdbp);
                 m_wdbp = 0;
@@ -139,11 +295,11 @@ bool MemoryDatabase::Load
             RT_CK_DBI(dbip);
 
             m_rtip = rt_new_rti(dbip);
-            rt_init_resource(m_resp, 0, m_rtip);
+            InitResources();
             m_wdbp = dbip->dbi_wdbp_inmem;
 
             // fill database
-            ret = (db_dump(m_wdbp, source->rti_dbip) == 0);
+            ret = CopyObjects(m_wdbp, source->rti_dbip);
 
             assert(m_wdbp->dbip == m_rtip->rti_dbip);
             db_update_ident(m_wdbp->dbip, source->rti_dbip->dbi_title, source->rti_dbip->dbi_base2local);
@@ -157,8 +157,15 @@ void Object::SetName
     // not connected with a non-writable database
     assert(((m_dbip != 0) && !m_dbip->dbi_read_only) || (m_pDir == 0));
 
-    if ((m_dbip != 0) && !m_dbip->dbi_read_only) // connected with a writable BRLCAD::Database
-        db_rename(m_dbip, m_pDir, name);
+    if ((m_dbip != 0) && !m_dbip->dbi_read_only) { // connected with a writable BRLCAD::Database
+        // e.g. Database::Set() copies the name too
+        if ((name != 0) && (strcmp(m_pDir->d_namep, name) != 0)) {
+            assert(!m_fixedName);
+
+            if (!m_fixedName)
+                db_rename(m_dbip, m_pDir, name);
+        }
+    }
     else if (m_pDir == 0) {                      // connected with no database at all
         if (name != 0) {
             if (!BU_SETJUMP) {
@@ -317,7 +324,7 @@ void Object::ClearAttributes(void) {
 }
 
 
-Object::Object(void) : m_pDir(0), m_ip(0), m_dbip(0), m_name(0), m_avs(0) {
+Object::Object(void) : m_pDir(0), m_ip(0), m_dbip(0), m_name(0), m_avs(0), m_fixedName(false) {
     if (!BU_SETJUMP) {
         m_resp = static_cast<resource*>(bu_calloc(1, sizeof(resource), "BRLCAD::Object::Object::m_resp"));
         rt_init_resource(m_resp, 0, NULL);
@@ -336,7 +343,7 @@ Object::Object
     directory*      pDir,
     rt_db_internal* ip,
     db_i*           dbip
-) : m_resp(resp), m_pDir(pDir), m_ip(ip), m_dbip(dbip), m_name(0), m_avs(0) {
+) : m_resp(resp), m_pDir(pDir), m_ip(ip), m_dbip(dbip), m_name(0), m_avs(0), m_fixedName(false) {
     assert(m_pDir != 0);
 }
 
@@ -344,7 +351,7 @@ Object::Object
 Object::Object
 (
     const Object& original
-) : m_resp(0), m_pDir(0), m_ip(0), m_dbip(0), m_name(0), m_avs(0) {
+) : m_resp(0), m_pDir(0), m_ip(0), m_dbip(0), m_name(0), m_avs(0), m_fixedName(false) {
     if (!BU_SETJUMP) {
         m_resp = static_cast<resource*>(bu_calloc(1, sizeof(resource), "BRLCAD::Object::Object::m_resp"));
         rt_init_resource(m_resp, 0, NULL);
@@ -389,7 +396,7 @@ void Object::Copy
 
                     // copy the bu_attribute_value_set
                     for (size_t i = 0; i < origAvs->count; ++i)
-                        bu_avs_add_nonunique(avs, origAvs->avp->name, origAvs->avp->value);
+                        bu_avs_add_nonunique(avs, origAvs->avp[i].name, origAvs->avp[i].value);
                 }
                 else {
                     BU_UNSETJUMP;
@@ -36,6 +36,29 @@
 using namespace BRLCAD;
 
 
+static wdb_pipe_pnt* NewControlPoint
+(
+    const double* point,
+    double        innerDiameter,
+    double        outerDiameter,
+    double        bendRadius,
+    const char*   label
+) {
+    wdb_pipe_pnt* ret = static_cast<wdb_pipe_pnt*>(bu_calloc(1, sizeof(wdb_pipe_pnt), label));
+
+    ret->l.magic = WDB_PIPESEG_MAGIC;
+
+    for (size_t i = 0; i < 3; ++i)
+        ret->pp_coord[i] = point[i];
+
+    ret->pp_id         = innerDiameter;
+    ret->pp_od         = outerDiameter;
+    ret->pp_bendradius = bendRadius;
+
+    return ret;
+}
+
+
 static void PipeCopy
 (
     rt_pipe_internal*       copiedPipe,
@@ -44,52 +67,16 @@ static void PipeCopy
     RT_PIPE_CK_MAGIC(copiedPipe);
     RT_PIPE_CK_MAGIC(originalPipe);
 
-    /* Initialize the new pipe internal structure */
     bu_list_free(&copiedPipe->pipe_segs_head);
     copiedPipe->pipe_count = originalPipe->pipe_count;
 
-    if (originalPipe->pipe_count > 0) {
-        /* We use two pointers here : One traverses the pipe internal
-        * to be copied and one traverses the pipe internal where it
-        * is being copied.
-        */
-        wdb_pipe_pnt* temp = BU_LIST_FIRST(wdb_pipe_pnt, &(originalPipe->pipe_segs_head));
-        wdb_pipe_pnt* itr  = BU_LIST_FIRST(wdb_pipe_pnt, &(copiedPipe->pipe_segs_head));
-
-        /* Allocate memory for every new entry in the bu_list of the
-        * new pipe internal and copy the contents of pipe internal to
-        * be copied into it. We use a separate structure for that
-        * and that push that structure into the list. ------> (1)
-        */
-        wdb_pipe_pnt* ctlPoint;
-        BU_GET(ctlPoint, wdb_pipe_pnt);
+    // append a copy of every control point in one walk through the list
+    const wdb_pipe_pnt* original;
 
-        for (size_t i = 0; i < 3; ++i)
-            ctlPoint->pp_coord[i] = temp->pp_coord[i];
+    for (BU_LIST_FOR(original, wdb_pipe_pnt, &originalPipe->pipe_segs_head)) {
+        wdb_pipe_pnt* ctlPoint = NewControlPoint(original->pp_coord, original->pp_id, original->pp_od, original->pp_bendradius, "BRLCAD Pipe interface PipeCopy");
 
-        ctlPoint->pp_id         = temp->pp_id;
-        ctlPoint->pp_od         = temp->pp_od;
-        ctlPoint->pp_bendradius = temp->pp_bendradius;
-
-        BU_LIST_PUSH(&itr->l, &ctlPoint->l);
-
-        /* Perform the task done in (1) iteratively till the complete
-        * list has been formed.
-        */
-        for (int count = 1; count < copiedPipe->pipe_count; ++count) {
-            itr  = BU_LIST_NEXT(wdb_pipe_pnt, &itr->l);
-            temp = BU_LIST_NEXT(wdb_pipe_pnt, &temp->l);
-            BU_GET(ctlPoint, wdb_pipe_pnt);
-
-            for (size_t i = 0; i < 3; ++i)
-                ctlPoint->pp_coord[i] = temp->pp_coord[i];
-
-            ctlPoint->pp_id         = temp->pp_id;
-            ctlPoint->pp_od         = temp->pp_od;
-            ctlPoint->pp_bendradius = temp->pp_bendradius;
-
-            BU_LIST_PUSH(&itr->l, &ctlPoint->l);
-        }
+        BU_LIST_INSERT(&copiedPipe->pipe_segs_head, &ctlPoint->l);
     }
 }
 
@@ -111,7 +98,7 @@ rt_pipe_internal* ClonePipeInternal
 }
 
 
-Pipe::Pipe(void) : Object() {
+Pipe::Pipe(void) : Object(), m_controlPoints(0), m_controlPointsCapacity(0), m_controlPointsValid(false) {
     if (!BU_SETJUMP) {
         BU_GET(m_internalp, rt_pipe_internal);
         m_internalp->pipe_magic = RT_PIPE_INTERNAL_MAGIC;
@@ -128,7 +115,7 @@ Pipe::Pipe(void) : Object() {
 Pipe::Pipe
 (
     const Pipe& original
-) {
+) : m_controlPoints(0), m_controlPointsCapacity(0), m_controlPointsValid(false) {
     if (!BU_SETJUMP)
         m_internalp = ClonePipeInternal(*original.Internal());
     else
@@ -146,6 +133,9 @@ Pipe::~Pipe
         bu_list_free(&m_internalp->pipe_segs_head);
         bu_free(m_internalp, "BRLCAD::Pipe::~Pipe::m_internalp");
     }
+
+    if (m_controlPoints != 0)
+        bu_free(m_controlPoints, "BRLCAD::Pipe::~Pipe::m_controlPoints");
 }
 
 
@@ -156,8 +146,10 @@ const Pipe& Pipe::operator=
     if (&original != this) {
         Copy(original);
 
-        if (!BU_SETJUMP)
+        if (!BU_SETJUMP) {
             PipeCopy(Internal(), original.Internal());
+            m_controlPointsValid = false;
+        }
         else
             BU_UNSETJUMP;
 
@@ -267,6 +259,32 @@ size_t Pipe::NumberOfControlPoints(void) const {
 }
 
 
+const Pipe::ControlPointIterator& Pipe::ControlPointIterator::operator++(void) {
+    assert(m_controlPoint != 0);
+
+    if (m_controlPoint != 0) {
+        m_controlPoint = BU_LIST_NEXT(wdb_pipe_pnt, &m_controlPoint->l);
+
+        if (BU_LIST_IS_HEAD(&m_controlPoint->l, &m_pipe->pipe_segs_head))
+            m_controlPoint = 0;
+    }
+
+    return *this;
+}
+
+
+Pipe::ControlPoint Pipe::ControlPointIterator::operator*(void) const {
+    assert(m_controlPoint != 0);
+
+    Pipe::ControlPoint ret;
+
+    if (m_controlPoint != 0)
+        ret = ControlPoint(m_pipe, m_controlPoint);
+
+    return ret;
+}
+
+
 Pipe::ControlPoint Pipe::GetControlPoint
 (
     size_t index
@@ -274,21 +292,30 @@ Pipe::ControlPoint Pipe::GetControlPoint
     assert(index < Internal()->pipe_count);
 
     Pipe::ControlPoint ret;
-    bu_list*           seghead = &Internal()->pipe_segs_head;
 
     if (index < Internal()->pipe_count) {
-        wdb_pipe_pnt* itr = BU_LIST_FIRST(wdb_pipe_pnt, seghead);
-
-        for (size_t count = 0; count < index; ++count)
-            itr = BU_LIST_NEXT(wdb_pipe_pnt, &itr->l);
+        if (!BU_SETJUMP)
+            ret = ControlPoint(Internal(), ControlPoints()[index]);
+        else
+            BU_UNSETJUMP;
 
-        ret = ControlPoint(Internal(), itr);
+        BU_UNSETJUMP;
     }
 
     return ret;
 }
 
 
+Pipe::ControlPointIterator Pipe::FirstControlPoint(void) {
+    Pipe::ControlPointIterator ret;
+
+    if (Internal()->pipe_count > 0)
+        ret = ControlPointIterator(Internal(), BU_LIST_FIRST(wdb_pipe_pnt, &Internal()->pipe_segs_head));
+
+    return ret;
+}
+
+
 Pipe::ControlPoint Pipe::AppendControlPoint
 (
     const Vector3D& point,
@@ -299,14 +326,16 @@ Pipe::ControlPoint Pipe::AppendControlPoint
     Pipe::ControlPoint ret;
 
     if (!BU_SETJUMP) {
-        wdb_pipe_pnt* ctlPoint = static_cast<wdb_pipe_pnt*>(bu_calloc(1, sizeof(wdb_pipe_pnt),"BRLCAD::Pipe::AppendControlPoint: wdb_pipe_pnt"));
+        wdb_pipe_pnt* ctlPoint = NewControlPoint(point.coordinates, innerDiameter, outerDiameter, bendRadius, "BRLCAD::Pipe::AppendControlPoint: wdb_pipe_pnt");
 
-        for (int i = 0; i < 3; i++)
-            ctlPoint->pp_coord[i] = point.coordinates[i];
+        if (m_controlPointsValid) {
+            if (m_controlPointsCapacity <= Internal()->pipe_count) {
+                m_controlPointsCapacity = 2 * Internal()->pipe_count + 1;
+                m_controlPoints         = static_cast<wdb_pipe_pnt**>(bu_realloc(m_controlPoints, m_controlPointsCapacity * sizeof(wdb_pipe_pnt*), "BRLCAD::Pipe::AppendControlPoint: m_controlPoints"));
+            }
 
-        ctlPoint->pp_id         = innerDiameter;
-        ctlPoint->pp_od         = outerDiameter;
-        ctlPoint->pp_bendradius = bendRadius;
+            m_controlPoints[Internal()->pipe_count] = ctlPoint;
+        }
 
         BU_LIST_PUSH(&Internal()->pipe_segs_head, &ctlPoint->l);
         Internal()->pipe_count += 1;
@@ -316,6 +345,8 @@ Pipe::ControlPoint Pipe::AppendControlPoint
     else
         BU_UNSETJUMP;
 
+    BU_UNSETJUMP;
+
     return ret;
 }
 
@@ -334,27 +365,31 @@ Pipe::ControlPoint Pipe::InsertControlPoint
 
     if (index <= Internal()->pipe_count) {
         if (!BU_SETJUMP) {
-            wdb_pipe_pnt* ctlPoint = static_cast<wdb_pipe_pnt*>(bu_calloc(1, sizeof(wdb_pipe_pnt),"BRLCAD::Pipe::InsertControlPoint: wdb_pipe_pnt"));
-
-            for (size_t i = 0; i < 3; ++i)
-                ctlPoint->pp_coord[i] = point.coordinates[i];
+            wdb_pipe_pnt** controlPoints = ControlPoints();
+            wdb_pipe_pnt*  ctlPoint      = NewControlPoint(point.coordinates, innerDiameter, outerDiameter, bendRadius, "BRLCAD::Pipe::InsertControlPoint: wdb_pipe_pnt");
 
-            ctlPoint->pp_id         = innerDiameter;
-            ctlPoint->pp_od         = outerDiameter;
-            ctlPoint->pp_bendradius = bendRadius;
+            // inserting before the head appends
+            if (index < Internal()->pipe_count)
+                BU_LIST_INSERT(&controlPoints[index]->l, &ctlPoint->l);
+            else
+                BU_LIST_INSERT(&Internal()->pipe_segs_head, &ctlPoint->l);
 
-            wdb_pipe_pnt* itr = BU_LIST_FIRST(wdb_pipe_pnt, &Internal()->pipe_segs_head);
+            if (m_controlPointsCapacity <= Internal()->pipe_count) {
+                m_controlPointsCapacity = 2 * Internal()->pipe_count + 1;
+                m_controlPoints         = static_cast<wdb_pipe_pnt**>(bu_realloc(m_controlPoints, m_controlPointsCapacity * sizeof(wdb_pipe_pnt*), "BRLCAD::Pipe::InsertControlPoint: m_controlPoints"));
+            }
 
-            for (size_t count = 0; count < index; ++count)
-                itr = BU_LIST_NEXT(wdb_pipe_pnt, &itr->l);
+            memmove(m_controlPoints + index + 1, m_controlPoints + index, (Internal()->pipe_count - index) * sizeof(wdb_pipe_pnt*));
+            m_controlPoints[index] = ctlPoint;
 
-            BU_LIST_INSERT(&itr->l, &ctlPoint->l);
             Internal()->pipe_count += 1;
 
             ret = ControlPoint(Internal(), ctlPoint);
         }
         else
             BU_UNSETJUMP;
+
+        BU_UNSETJUMP;
     }
 
     return ret;
@@ -368,19 +403,60 @@ void Pipe::DeleteControlPoint
     assert(index < Internal()->pipe_count);
 
     if (index < Internal()->pipe_count) {
-        wdb_pipe_pnt* itr = BU_LIST_FIRST(wdb_pipe_pnt, &Internal()->pipe_segs_head);
+        if (!BU_SETJUMP) {
+            wdb_pipe_pnt** controlPoints = ControlPoints();
+            wdb_pipe_pnt*  itr           = controlPoints[index];
 
-        for (size_t count = 0; count < index; ++count)
-            itr = BU_LIST_NEXT(wdb_pipe_pnt, &itr->l);
+            BU_LIST_DEQUEUE(&(itr->l));
+            bu_free(&(itr->l), "BRLCAD::Pipe::DeleteControlPoint");
 
-        BU_LIST_DEQUEUE(&(itr->l));
-        bu_free(&(itr->l), "BRLCAD::Pipe::DeleteControlPoint");
+            memmove(controlPoints + index, controlPoints + index + 1, (Internal()->pipe_count - index - 1) * sizeof(wdb_pipe_pnt*));
 
-        Internal()->pipe_count -= 1;
+            Internal()->pipe_count -= 1;
+        }
+        else
+            BU_UNSETJUMP;
+
+        BU_UNSETJUMP;
     }
 }
 
 
+void Pipe::SetControlPoints
+(
+    const double* points,
+    const double* innerDiameters,
+    const double* outerDiameters,
+    const double* bendRadii,
+    size_t        numberOfControlPoints
+) {
+    if (!BU_SETJUMP) {
+        rt_pipe_internal* pipe = Internal();
+
+        bu_list_free(&pipe->pipe_segs_head);
+
+        if (m_controlPointsCapacity < numberOfControlPoints) {
+            m_controlPointsCapacity = numberOfControlPoints;
+            m_controlPoints         = static_cast<wdb_pipe_pnt**>(bu_realloc(m_controlPoints, m_controlPointsCapacity * sizeof(wdb_pipe_pnt*), "BRLCAD::Pipe::SetControlPoints: m_controlPoints"));
+        }
+
+        for (size_t i = 0; i < numberOfControlPoints; ++i) {
+            wdb_pipe_pnt* ctlPoint = NewControlPoint(points + 3 * i, innerDiameters[i], outerDiameters[i], bendRadii[i], "BRLCAD::Pipe::SetControlPoints: wdb_pipe_pnt");
+
+            BU_LIST_INSERT(&pipe->pipe_segs_head, &ctlPoint->l);
+            m_controlPoints[i] = ctlPoint;
+        }
+
+        pipe->pipe_count     = static_cast<int>(numberOfControlPoints);
+        m_controlPointsValid = true;
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+}
+
+
 const Object& Pipe::operator=
 (
     const Object& original
@@ -425,7 +501,7 @@ Pipe::Pipe
     directory*      pDir,
     rt_db_internal* ip,
     db_i*           dbip
-) : Object(resp, pDir, ip, dbip), m_internalp(0) {}
+) : Object(resp, pDir, ip, dbip), m_internalp(0), m_controlPoints(0), m_controlPointsCapacity(0), m_controlPointsValid(false) {}
 
 
 const rt_pipe_internal* Pipe::Internal(void) const {
@@ -454,3 +530,25 @@ rt_pipe_internal* Pipe::Internal(void) {
 
     return ret;
 }
+
+
+wdb_pipe_pnt** Pipe::ControlPoints(void) {
+    if (!m_controlPointsValid) {
+        rt_pipe_internal* pipe = Internal();
+
+        if (m_controlPointsCapacity < static_cast<size_t>(pipe->pipe_count) + 1) {
+            m_controlPointsCapacity = pipe->pipe_count + 1;
+            m_controlPoints         = static_cast<wdb_pipe_pnt**>(bu_realloc(m_controlPoints, m_controlPointsCapacity * sizeof(wdb_pipe_pnt*), "BRLCAD::Pipe::ControlPoints"));
+        }
+
+        size_t        count = 0;
+        wdb_pipe_pnt* ctlPoint;
+
+        for (BU_LIST_FOR(ctlPoint, wdb_pipe_pnt, &pipe->pipe_segs_head))
+            m_controlPoints[count++] = ctlPoint;
+
+        m_controlPointsValid = true;
+    }
+
+    return m_controlPoints;
+}
@@ -25,6 +25,7 @@
 
 #include <cstring>
 #include <cassert>
+#include <cmath>
 
 #include "raytrace.h"
 #include "rt/geom.h"
@@ -36,148 +37,527 @@
 using namespace BRLCAD;
 
 
-static size_t AddToVerts
+namespace BRLCAD {
+    /// editing state of a rt_sketch_internal which is kept beside it
+    /** The vertex and segment arrays of the rt_sketch_internal may be bigger than their number of elements
+        (librt uses the numbers only) to let them grow geometrically.
+        The vertices are found via a hash table over a grid with the cell size VertexCellSize.
+        Vertices which are no longer used by any segment stay in the sketch until CompactVertices() removes them. */
+    struct SketchIndex {
+        size_t verticesCapacity;       ///< in vertices
+        size_t segmentsCapacity;       ///< in segments
+        bool   hashValid;              ///< the hash table contains all vertices of the sketch
+        size_t numberOfBuckets;        ///< a power of 2
+        int*   buckets;                ///< first vertex in the bucket, -1 if empty
+        int*   nextVertices;           ///< next vertex in the same bucket, -1 at the end, verticesCapacity entries
+        bool   usageValid;             ///< vertexUsage and numberOfUnusedVertices are up to date
+        int*   vertexUsage;            ///< number of references of the segments to the vertex, verticesCapacity entries
+        size_t numberOfUnusedVertices;
+    };
+}
+
+
+// has to be bigger than the welding tolerance VUNITIZE_TOL and small enough to keep the cell coordinates in the int64_t range
+static const double VertexCellSize = 1.e-6;
+
+
+static void* Reserve
 (
-    const point2d_t&    point,
-    rt_sketch_internal& sketch
+    void*       array,
+    size_t&     capacity,
+    size_t      numberOfElements,
+    size_t      elementSize,
+    const char* label
+) {
+    void* ret = array;
+
+    if ((numberOfElements > capacity) || (array == 0)) {
+        size_t newCapacity = 2 * capacity;
+
+        if (newCapacity < numberOfElements)
+            newCapacity = numberOfElements;
+
+        if (newCapacity < 1)
+            newCapacity = 1;
+
+        ret      = bu_realloc(array, newCapacity * elementSize, label);
+        capacity = newCapacity;
+    }
+
+    return ret;
+}
+
+
+/// calls a function for every reference of a segment to a vertex
+typedef void (*VertexReferenceFunction)(int& vertex, void* data);
+
+static void ForEachVertexReference
+(
+    void*                   segment,
+    VertexReferenceFunction function,
+    void*                   data
 ) {
-    size_t ret = 0; // index of the added vertex
+    const uint32_t *magic = static_cast<uint32_t*>(segment);
+
+    switch (*magic) {
+        case CURVE_LSEG_MAGIC: {
+                line_seg* line = static_cast<line_seg*>(segment);
+
+                function(line->start, data);
+                function(line->end, data);
+            }
+            break;
+
+        case CURVE_CARC_MAGIC: {
+                carc_seg* carc = static_cast<carc_seg*>(segment);
+
+                function(carc->start, data);
+                function(carc->end, data);
+                function(carc->center, data);
+            }
+            break;
 
-    // vertex already there?
-    for (; ret < sketch.vert_count; ++ret) {
-        if (V2NEAR_EQUAL(point, sketch.verts[ret], VUNITIZE_TOL))
+        case CURVE_NURB_MAGIC: {
+                nurb_seg* nurb = static_cast<nurb_seg*>(segment);
+
+                for (int i = 0; i < nurb->c_size; ++i)
+                    function(nurb->ctl_points[i], data);
+            }
             break;
+
+        case CURVE_BEZIER_MAGIC: {
+                bezier_seg* bezier = static_cast<bezier_seg*>(segment);
+
+                if (bezier->ctl_points != 0) {
+                    for (int i = 0; i <= bezier->degree; ++i)
+                        function(bezier->ctl_points[i], data);
+                }
+            }
     }
+}
 
-    if (ret == sketch.vert_count) {
-        // add a new vertex
-        ++sketch.vert_count;
-        sketch.verts = static_cast<point2d_t*>(bu_realloc(sketch.verts,
-                                                          sketch.vert_count * sizeof(point2d_t),
-                                                          "BRLCAD sketch interface AddToVerts"));
 
-        V2MOVE(sketch.verts[ret], point);
+static void InvalidateHash
+(
+    SketchIndex& index
+) {
+    if (index.buckets != 0) {
+        bu_free(index.buckets, "BRLCAD sketch interface InvalidateHash: buckets");
+        index.buckets = 0;
     }
 
-    return ret;
+    if (index.nextVertices != 0) {
+        bu_free(index.nextVertices, "BRLCAD sketch interface InvalidateHash: nextVertices");
+        index.nextVertices = 0;
+    }
+
+    index.numberOfBuckets = 0;
+    index.hashValid       = false;
 }
 
 
-static void RemoveFromVerts
+static void InvalidateVertexUsage
 (
-    size_t              index,
-    rt_sketch_internal& sketch
+    SketchIndex& index
 ) {
-    assert(index < sketch.vert_count);
+    if (index.vertexUsage != 0) {
+        bu_free(index.vertexUsage, "BRLCAD sketch interface InvalidateVertexUsage: vertexUsage");
+        index.vertexUsage = 0;
+    }
 
-    if (index < sketch.vert_count) {
-        // is the vertex used elsewhere?
-        size_t vertexUsage = 0;
+    index.numberOfUnusedVertices = 0;
+    index.usageValid             = false;
+}
 
-        for (int i = 0; i < sketch.curve.count; ++i) {
-            const uint32_t *magic = static_cast<uint32_t*>(sketch.curve.segment[i]);
 
-            switch (*magic) {
-                case CURVE_LSEG_MAGIC: {
-                        line_seg* line = static_cast<line_seg*>(sketch.curve.segment[i]);
+/// the arrays of the sketch have their exact sizes, e.g. after a copy
+static void ResetIndex
+(
+    SketchIndex&              index,
+    const rt_sketch_internal& sketch
+) {
+    InvalidateHash(index);
+    InvalidateVertexUsage(index);
 
-                        if (line->start == index)
-                            ++vertexUsage;
+    index.verticesCapacity = sketch.vert_count;
+    index.segmentsCapacity = sketch.curve.count;
+}
 
-                        if (line->end == index)
-                            ++vertexUsage;
-                    }
-                    break;
 
-                case CURVE_CARC_MAGIC: {
-                        carc_seg* carc = static_cast<carc_seg*>(sketch.curve.segment[i]);
+static void FreeIndex
+(
+    SketchIndex* index
+) {
+    if (index != 0) {
+        InvalidateHash(*index);
+        InvalidateVertexUsage(*index);
+        bu_free(index, "BRLCAD sketch interface FreeIndex");
+    }
+}
 
-                        if (carc->start == index)
-                            ++vertexUsage;
 
-                        if (carc->end == index)
-                            ++vertexUsage;
-                    }
-                    break;
+/// returns the index of a sketch, creates it with the first edit
+static SketchIndex& GetIndex
+(
+    SketchIndex*&             index,
+    const rt_sketch_internal& sketch
+) {
+    if (index == 0) {
+        index = static_cast<SketchIndex*>(bu_calloc(1, sizeof(SketchIndex), "BRLCAD sketch interface GetIndex"));
 
-                case CURVE_NURB_MAGIC: {
-                        nurb_seg* nurb = static_cast<nurb_seg*>(sketch.curve.segment[i]);
+        ResetIndex(*index, sketch);
+    }
 
-                        for (size_t j = 0; j < nurb->c_size; ++j) {
-                            if (nurb->ctl_points[j] == index)
-                                ++vertexUsage;
-                        }
-                    }
+    return *index;
+}
+
+
+static int64_t VertexCell
+(
+    fastf_t coordinate
+) {
+    return static_cast<int64_t>(floor(coordinate / VertexCellSize));
+}
+
+
+static size_t CellBucket
+(
+    int64_t x,
+    int64_t y,
+    size_t  numberOfBuckets
+) {
+    uint64_t hash = (static_cast<uint64_t>(x) * 73856093U) ^ (static_cast<uint64_t>(y) * 19349663U);
+
+    return static_cast<size_t>(hash & (numberOfBuckets - 1));
+}
+
+
+static void HashVertex
+(
+    SketchIndex&              index,
+    const rt_sketch_internal& sketch,
+    int                       vertex
+) {
+    size_t bucket = CellBucket(VertexCell(sketch.verts[vertex][0]), VertexCell(sketch.verts[vertex][1]), index.numberOfBuckets);
+
+    index.nextVertices[vertex] = index.buckets[bucket];
+    index.buckets[bucket]      = vertex;
+}
+
+
+/// (re-)builds the hash table with at least one bucket per vertex
+static void BuildHash
+(
+    SketchIndex&              index,
+    const rt_sketch_internal& sketch
+) {
+    size_t numberOfBuckets = 64;
+
+    while (numberOfBuckets < sketch.vert_count)
+        numberOfBuckets *= 2;
+
+    if (index.buckets != 0)
+        bu_free(index.buckets, "BRLCAD sketch interface BuildHash: buckets");
+
+    index.buckets         = static_cast<int*>(bu_malloc(numberOfBuckets * sizeof(int), "BRLCAD sketch interface BuildHash: buckets"));
+    index.numberOfBuckets = numberOfBuckets;
+
+    for (size_t i = 0; i < numberOfBuckets; ++i)
+        index.buckets[i] = -1;
+
+    size_t capacity = index.verticesCapacity;
+
+    if (capacity < sketch.vert_count)
+        capacity = sketch.vert_count;
+
+    if (capacity < 1)
+        capacity = 1;
+
+    index.nextVertices = static_cast<int*>(bu_realloc(index.nextVertices, capacity * sizeof(int), "BRLCAD sketch interface BuildHash: nextVertices"));
+
+    for (int i = 0; i < static_cast<int>(sketch.vert_count); ++i)
+        HashVertex(index, sketch, i);
+
+    index.hashValid = true;
+}
+
+
+static void CountVertexReference
+(
+    int&  vertex,
+    void* data
+) {
+    ++static_cast<int*>(data)[vertex];
+}
+
+
+/// counts the references of the segments to the vertices
+static void BuildVertexUsage
+(
+    SketchIndex&              index,
+    const rt_sketch_internal& sketch
+) {
+    size_t capacity = index.verticesCapacity;
+
+    if (capacity < sketch.vert_count)
+        capacity = sketch.vert_count;
+
+    if (capacity < 1)
+        capacity = 1;
+
+    index.vertexUsage = static_cast<int*>(bu_realloc(index.vertexUsage, capacity * sizeof(int), "BRLCAD sketch interface BuildVertexUsage: vertexUsage"));
+    memset(index.vertexUsage, 0, capacity * sizeof(int));
+
+    for (size_t i = 0; i < sketch.curve.count; ++i)
+        ForEachVertexReference(sketch.curve.segment[i], CountVertexReference, index.vertexUsage);
+
+    index.numberOfUnusedVertices = 0;
+
+    for (size_t i = 0; i < sketch.vert_count; ++i) {
+        if (index.vertexUsage[i] == 0)
+            ++index.numberOfUnusedVertices;
+    }
+
+    index.usageValid = true;
+}
+
+
+static void UseVertex
+(
+    int&  vertex,
+    void* data
+) {
+    SketchIndex* index = static_cast<SketchIndex*>(data);
+
+    if (index->usageValid) {
+        if (index->vertexUsage[vertex] == 0)
+            --index->numberOfUnusedVertices;
+
+        ++index->vertexUsage[vertex];
+    }
+}
+
+
+static void ReleaseVertex
+(
+    int&  vertex,
+    void* data
+) {
+    SketchIndex* index = static_cast<SketchIndex*>(data);
+
+    if (index->usageValid) {
+        assert(index->vertexUsage[vertex] > 0);
+
+        --index->vertexUsage[vertex];
+
+        if (index->vertexUsage[vertex] == 0)
+            ++index->numberOfUnusedVertices;
+    }
+}
+
+
+static int FindVertex
+(
+    const point2d_t&          point,
+    SketchIndex&              index,
+    const rt_sketch_internal& sketch
+) {
+    int ret = -1;
+
+    if (!index.hashValid)
+        BuildHash(index, sketch);
+
+    // the vertices within the tolerance may be in the neighbour cells
+    int64_t minCell[2];
+    int64_t maxCell[2];
+
+    for (int i = 0; i < 2; ++i) {
+        minCell[i] = VertexCell(point[i] - VUNITIZE_TOL);
+        maxCell[i] = VertexCell(point[i] + VUNITIZE_TOL);
+    }
+
+    for (int64_t x = minCell[0]; (x <= maxCell[0]) && (ret < 0); ++x) {
+        for (int64_t y = minCell[1]; (y <= maxCell[1]) && (ret < 0); ++y) {
+            for (int vertex = index.buckets[CellBucket(x, y, index.numberOfBuckets)]; vertex >= 0; vertex = index.nextVertices[vertex]) {
+                if (V2NEAR_EQUAL(point, sketch.verts[vertex], VUNITIZE_TOL)) {
+                    ret = vertex;
                     break;
+                }
+            }
+        }
+    }
 
-                case CURVE_BEZIER_MAGIC: {
-                        bezier_seg* bezier = static_cast<bezier_seg*>(sketch.curve.segment[i]);
+    return ret;
+}
 
-                        for (size_t j = 0; j <= bezier->degree; ++j) {
-                            if (bezier->ctl_points[j] == index)
-                                ++vertexUsage;
-                        }
-                    }
 
+/// adds a vertex or returns an existing one within the tolerance
+/** The caller has to register the usage of the returned vertex with UseVertex(). */
+static int AddToVerts
+(
+    const point2d_t&    point,
+    rt_sketch_internal& sketch,
+    SketchIndex&        index
+) {
+    int ret = FindVertex(point, index, sketch); // index of the added vertex
+
+    if (ret < 0) {
+        // add a new vertex
+        ret = static_cast<int>(sketch.vert_count);
+
+        size_t verticesCapacity = index.verticesCapacity;
+
+        sketch.verts = static_cast<point2d_t*>(Reserve(sketch.verts, index.verticesCapacity, sketch.vert_count + 1, sizeof(point2d_t), "BRLCAD sketch interface AddToVerts"));
+
+        if (index.verticesCapacity != verticesCapacity) {
+            index.nextVertices = static_cast<int*>(bu_realloc(index.nextVertices, index.verticesCapacity * sizeof(int), "BRLCAD sketch interface AddToVerts: nextVertices"));
+
+            if (index.usageValid)
+                index.vertexUsage = static_cast<int*>(bu_realloc(index.vertexUsage, index.verticesCapacity * sizeof(int), "BRLCAD sketch interface AddToVerts: vertexUsage"));
+        }
+
+        if (index.usageValid) {
+            index.vertexUsage[ret] = 0;
+            ++index.numberOfUnusedVertices;
+        }
+
+        V2MOVE(sketch.verts[ret], point);
+        ++sketch.vert_count;
+
+        if (sketch.vert_count > index.numberOfBuckets)
+            BuildHash(index, sketch);
+        else
+            HashVertex(index, sketch, ret);
+    }
+
+    return ret;
+}
+
+
+static void RenumberVertexReference
+(
+    int&  vertex,
+    void* data
+) {
+    vertex = static_cast<int*>(data)[vertex];
+}
+
+
+/// removes all vertices which aren't used by a segment in one pass
+static void CompactVertices
+(
+    rt_sketch_internal& sketch,
+    SketchIndex&        index
+) {
+    if (sketch.vert_count > 0) {
+        int* newIndices = static_cast<int*>(bu_calloc(sketch.vert_count, sizeof(int), "BRLCAD sketch interface CompactVertices: newIndices"));
+
+        for (size_t i = 0; i < sketch.curve.count; ++i)
+            ForEachVertexReference(sketch.curve.segment[i], CountVertexReference, newIndices);
+
+        size_t numberOfVertices = 0;
+
+        for (size_t i = 0; i < sketch.vert_count; ++i) {
+            if (newIndices[i] != 0) {
+                if (numberOfVertices < i)
+                    V2MOVE(sketch.verts[numberOfVertices], sketch.verts[i]);
+
+                newIndices[i] = static_cast<int>(numberOfVertices);
+                ++numberOfVertices;
             }
         }
 
-        if (vertexUsage <= 1) {
-            // really remove it
-            memmove(sketch.verts + index, sketch.verts + index + 1, (sketch.vert_count - index - 1) * sizeof(point2d_t));
+        if (numberOfVertices < sketch.vert_count) {
+            for (size_t i = 0; i < sketch.curve.count; ++i)
+                ForEachVertexReference(sketch.curve.segment[i], RenumberVertexReference, newIndices);
 
-            --sketch.vert_count;
-            sketch.verts = static_cast<point2d_t*>(bu_realloc(sketch.verts,
-                                                              sketch.vert_count * sizeof(point2d_t),
-                                                              "BRLCAD sketch interface RemoveFromVerts"));
+            sketch.vert_count = numberOfVertices;
+
+            InvalidateHash(index);
+            InvalidateVertexUsage(index);
         }
+
+        bu_free(newIndices, "BRLCAD sketch interface CompactVertices: newIndices");
     }
 }
 
 
-static size_t SwapVertex
+/// removes the unused vertices if they are more than the half of all vertices
+static void CompactIfSparse
 (
-    size_t              oldIndex,
+    rt_sketch_internal& sketch,
+    SketchIndex&        index
+) {
+    if (index.usageValid && (index.numberOfUnusedVertices > (sketch.vert_count / 2)))
+        CompactVertices(sketch, index);
+}
+
+
+/// lets the vertex reference \a vertex of a segment of \a sketch refer to \a newPoint
+static void SwapVertex
+(
+    int&                vertex,
     const point2d_t&    newPoint,
-    rt_sketch_internal& sketch
+    rt_sketch_internal& sketch,
+    SketchIndex&        index
 ) {
-    size_t ret = -1; // index of the new vertex
+    if (!V2NEAR_EQUAL(newPoint, sketch.verts[vertex], VUNITIZE_TOL)) {
+        if (!index.usageValid)
+            BuildVertexUsage(index, sketch);
+
+        ReleaseVertex(vertex, &index);
 
-    if (V2NEAR_EQUAL(newPoint, sketch.verts[oldIndex], VUNITIZE_TOL))
-        ret = oldIndex;
-    else {
-        RemoveFromVerts(oldIndex, sketch);
+        vertex = AddToVerts(newPoint, sketch, index);
+        UseVertex(vertex, &index);
 
-        ret = AddToVerts(newPoint, sketch);
+        // renumbers vertex too
+        CompactIfSparse(sketch, index);
     }
+}
 
-    return ret;
+
+/// makes sure that there is a vertex to reference by a new segment (index 0)
+static void EnsureVertex
+(
+    rt_sketch_internal& sketch,
+    SketchIndex&        index
+) {
+    if (sketch.vert_count == 0) {
+        point2d_t zero = {0.};
+
+        AddToVerts(zero, sketch, index);
+    }
+}
+
+
+static void ReserveSegments
+(
+    size_t              numberOfSegments,
+    rt_sketch_internal* sketch,
+    SketchIndex&        index
+) {
+    size_t capacity = index.segmentsCapacity;
+
+    sketch->curve.segment = static_cast<void**>(Reserve(sketch->curve.segment, index.segmentsCapacity, numberOfSegments, sizeof(void*), "BRLCAD sketch interface ReserveSegments: segment"));
+
+    if ((index.segmentsCapacity != capacity) || (sketch->curve.reverse == 0))
+        sketch->curve.reverse = static_cast<int*>(bu_realloc(sketch->curve.reverse, index.segmentsCapacity * sizeof(int), "BRLCAD sketch interface ReserveSegments: reverse"));
 }
 
 
 static void AppendSegment
 (
     void*               segment,
-    rt_sketch_internal* sketch
+    rt_sketch_internal* sketch,
+    SketchIndex&        index
 ) {
-    if (sketch->curve.count == 0) {
-        sketch->curve.reverse = static_cast<int*>(bu_malloc(sizeof(int),
-                                                            "BRLCAD sketch interface AppendSegment: reverse"));
-        sketch->curve.segment = static_cast<void**>(bu_malloc(sizeof(void*),
-                                                              "BRLCAD sketch interface AppendSegment: segment"));
-    }
-    else {
-        sketch->curve.reverse = static_cast<int*>(bu_realloc(sketch->curve.reverse,
-                                                             (sketch->curve.count + 1) * sizeof(int),
-                                                             "BRLCAD sketch interface AppendSegment: reverse"));
-        sketch->curve.segment = static_cast<void**>(bu_realloc(sketch->curve.segment,
-                                                               (sketch->curve.count + 1) * sizeof(void*),
-                                                               "BRLCAD sketch interface AppendSegment: segment"));
-    }
+    ReserveSegments(sketch->curve.count + 1, sketch, index);
 
     sketch->curve.reverse[sketch->curve.count] = 0;
     sketch->curve.segment[sketch->curve.count] = segment;
     ++(sketch->curve.count);
+
+    ForEachVertexReference(segment, UseVertex, &index);
 }
 
 
@@ -185,27 +565,25 @@ static void InsertSegment
 (
     void*               segment,
     size_t              index,
-    rt_sketch_internal* sketch
+    rt_sketch_internal* sketch,
+    SketchIndex&        sketchIndex
 ) {
     assert(sketch->curve.count > 0);
 
-    sketch->curve.reverse = static_cast<int*>(bu_realloc(sketch->curve.reverse,
-                                                         (sketch->curve.count + 1) * sizeof(int),
-                                                         "BRLCAD sketch interface InsertSegment: reverse"));
-    sketch->curve.segment = static_cast<void**>(bu_realloc(sketch->curve.segment,
-                                                           (sketch->curve.count + 1) * sizeof(void*),
-                                                           "BRLCAD sketch interface InsertSegment: segment"));
+    ReserveSegments(sketch->curve.count + 1, sketch, sketchIndex);
 
-    memmove(sketch->curve.segment + index + 1, sketch->curve.segment + index, (sketch->curve.count - index) * sizeof(int));
+    memmove(sketch->curve.reverse + index + 1, sketch->curve.reverse + index, (sketch->curve.count - index) * sizeof(int));
     memmove(sketch->curve.segment + index + 1, sketch->curve.segment + index, (sketch->curve.count - index) * sizeof(void*));
 
     sketch->curve.reverse[index] = 0;
     sketch->curve.segment[index] = segment;
     ++(sketch->curve.count);
+
+    ForEachVertexReference(segment, UseVertex, &sketchIndex);
 }
 
 
-Sketch::Sketch(void) : Object() {
+Sketch::Sketch(void) : Object(), m_index(0) {
     if (!BU_SETJUMP) {
         BU_GET(m_internalp, rt_sketch_internal);
         m_internalp->magic = RT_SKETCH_INTERNAL_MAGIC;
@@ -222,7 +600,7 @@ Sketch::Sketch(void) : Object() {
 Sketch::Sketch
 (
     const Sketch& original
-) {
+) : m_index(0) {
     if (!BU_SETJUMP)
         m_internalp = rt_copy_sketch(original.Internal());
     else
@@ -241,6 +619,8 @@ Sketch::~Sketch(void) {
 
         BU_PUT(m_internalp, rt_sketch_internal);
     }
+
+    FreeIndex(m_index);
 }
 
 
@@ -270,6 +650,9 @@ const Sketch& Sketch::operator=(
                 rt_curve_free(&thisInternal->curve);
                 rt_copy_curve(&thisInternal->curve, &originalInternal->curve);
             }
+
+            if (m_index != 0)
+                ResetIndex(*m_index, *thisInternal);
         }
         else
             BU_UNSETJUMP;
@@ -290,6 +673,51 @@ void Sketch::Segment::Destroy(void) {
 }
 
 
+/// the position of the segment in curve.reverse, 0 if it isn't in the sketch
+static int* ReverseFlag
+(
+    const void*         segment,
+    rt_sketch_internal* sketch
+) {
+    int* ret = 0;
+
+    if ((sketch != 0) && (segment != 0)) {
+        for (size_t i = 0; i < sketch->curve.count; ++i) {
+            if (sketch->curve.segment[i] == segment) {
+                ret = sketch->curve.reverse + i;
+                break;
+            }
+        }
+    }
+
+    return ret;
+}
+
+
+bool Sketch::Segment::Reverse(void) const {
+    bool       ret         = false;
+    const int* reverseFlag = ReverseFlag(SegmentInternal(), m_sketch);
+
+    if (reverseFlag != 0)
+        ret = (*reverseFlag != 0);
+
+    return ret;
+}
+
+
+void Sketch::Segment::SetReverse
+(
+    bool reverse
+) {
+    int* reverseFlag = ReverseFlag(SegmentInternal(), m_sketch);
+
+    assert(reverseFlag != 0);
+
+    if (reverseFlag != 0)
+        *reverseFlag = reverse ? 1 : 0;
+}
+
+
 //
 // Line class
 //
@@ -310,6 +738,11 @@ Sketch::Segment* Sketch::Line::Clone(void) const {
 }
 
 
+const void* Sketch::Line::SegmentInternal(void) const {
+    return m_lineSegment;
+}
+
+
 Vector2D Sketch::Line::StartPoint(void) const {
     assert(m_lineSegment != 0);
     assert(m_sketch != 0);
@@ -332,7 +765,7 @@ void Sketch::Line::SetStartPoint
 
     if ((m_lineSegment != 0) && (m_sketch != 0)) {
         if (!BU_SETJUMP)
-            SwapVertex(m_lineSegment->start, startPoint.coordinates, *m_sketch);
+            SwapVertex(m_lineSegment->start, startPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -363,7 +796,7 @@ void Sketch::Line::SetEndPoint
 
     if ((m_lineSegment != 0) && (m_sketch != 0)) {
         if (!BU_SETJUMP)
-            SwapVertex(m_lineSegment->end, endPoint.coordinates, *m_sketch);
+            SwapVertex(m_lineSegment->end, endPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -408,7 +841,7 @@ void Sketch::CircularArc::SetCenter(
     if ((m_circularArcSegment != 0) && (m_sketch != 0)) {
 
         if (!BU_SETJUMP)
-            SwapVertex(m_circularArcSegment->center, c.coordinates, *m_sketch);
+            SwapVertex(m_circularArcSegment->center, c.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -431,6 +864,11 @@ Sketch::Segment* Sketch::CircularArc::Clone(void) const {
 }
 
 
+const void* Sketch::CircularArc::SegmentInternal(void) const {
+    return m_circularArcSegment;
+}
+
+
 Vector2D Sketch::CircularArc::StartPoint(void) const {
     assert(m_circularArcSegment != 0);
     assert(m_sketch != 0);
@@ -454,7 +892,7 @@ void Sketch::CircularArc::SetStartPoint
     if ((m_circularArcSegment != 0) && (m_sketch != 0)) {
 
         if (!BU_SETJUMP)
-            SwapVertex(m_circularArcSegment->start, startPoint.coordinates, *m_sketch);
+            SwapVertex(m_circularArcSegment->start, startPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -478,7 +916,7 @@ void Sketch::CircularArc::SetEndPoint
     if ((m_circularArcSegment != 0) && (m_sketch != 0)) {
 
         if (!BU_SETJUMP)
-            SwapVertex(m_circularArcSegment->end, endPoint.coordinates, *m_sketch);
+            SwapVertex(m_circularArcSegment->end, endPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -563,6 +1001,11 @@ Sketch::Segment* Sketch::Nurb::Clone(void) const {
 }
 
 
+const void* Sketch::Nurb::SegmentInternal(void) const {
+    return m_nurbSegment;
+}
+
+
 Vector2D Sketch::Nurb::StartPoint(void) const {
     assert(m_nurbSegment != 0);
     assert(m_sketch != 0);
@@ -585,7 +1028,7 @@ void Sketch::Nurb::SetStartPoint
 
     if ((m_nurbSegment != 0) && (m_sketch != 0)) {
         if (!BU_SETJUMP)
-            SwapVertex(m_nurbSegment->ctl_points[0], startPoint.coordinates, *m_sketch);
+            SwapVertex(m_nurbSegment->ctl_points[0], startPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -601,7 +1044,7 @@ Vector2D Sketch::Nurb::EndPoint(void) const {
     Vector2D ret;
 
     if ((m_nurbSegment != 0) && (m_sketch != 0))
-        ret = Vector2D(m_sketch->verts[m_nurbSegment->ctl_points[m_nurbSegment->c_size]]);
+        ret = Vector2D(m_sketch->verts[m_nurbSegment->ctl_points[m_nurbSegment->c_size - 1]]);
 
     return ret;
 }
@@ -616,7 +1059,7 @@ void Sketch::Nurb::SetEndPoint
 
     if ((m_nurbSegment != 0) && (m_sketch != 0)) {
         if (!BU_SETJUMP)
-            SwapVertex(m_nurbSegment->ctl_points[m_nurbSegment->c_size], endPoint.coordinates, *m_sketch);
+            SwapVertex(m_nurbSegment->ctl_points[m_nurbSegment->c_size - 1], endPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -732,17 +1175,24 @@ void Sketch::Nurb::AddControlPoint
     assert(m_nurbSegment != 0);
     assert(m_sketch != 0);
 
-    size_t vcount = m_sketch->vert_count;
-    size_t ret    = AddToVerts(point.coordinates, *m_sketch);
+    if (!BU_SETJUMP) {
+        int vertex = AddToVerts(point.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
+
+        UseVertex(vertex, &GetIndex(*m_index, *m_sketch));
 
-    if (vcount < ret) {
         m_nurbSegment->c_size++;
         m_nurbSegment->ctl_points                            = static_cast<int*>(bu_realloc(m_nurbSegment->ctl_points, m_nurbSegment->c_size * sizeof(int), "BRLCAD::Sketch::Nurb::AddControlPoint"));
-        m_nurbSegment->ctl_points[m_nurbSegment->c_size - 1] = static_cast<int>(ret);
+        m_nurbSegment->ctl_points[m_nurbSegment->c_size - 1] = vertex;
 
-        if (!m_nurbSegment->weights)
-            m_nurbSegment->weights = static_cast<double*>(bu_realloc(m_nurbSegment->weights, m_nurbSegment->c_size * sizeof(fastf_t), "BRLCAD::Sketch::Nurb::AddControlPoint: weights"));
+        if (m_nurbSegment->weights != 0) {
+            m_nurbSegment->weights                            = static_cast<fastf_t*>(bu_realloc(m_nurbSegment->weights, m_nurbSegment->c_size * sizeof(fastf_t), "BRLCAD::Sketch::Nurb::AddControlPoint: weights"));
+            m_nurbSegment->weights[m_nurbSegment->c_size - 1] = 1.;
+        }
     }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
 }
 
 
@@ -754,12 +1204,23 @@ void Sketch::Nurb::AddControlPointWeight
     assert(m_nurbSegment != 0);
     assert(m_sketch != 0);
 
-    size_t ret = AddToVerts(point.coordinates, *m_sketch);
+    AddControlPoint(point);
 
-    if(!m_nurbSegment->weights) {
-        m_nurbSegment->weights      = static_cast<double*>(bu_calloc(m_nurbSegment->c_size, sizeof(fastf_t), "BRLCAD::Sketch::Nurb::AddControlPointWeight"));
-        m_nurbSegment->weights[ret] = weight;
+    if (!BU_SETJUMP) {
+        if (m_nurbSegment->weights == 0) {
+            // the curve becomes rational
+            m_nurbSegment->weights = static_cast<fastf_t*>(bu_malloc(m_nurbSegment->c_size * sizeof(fastf_t), "BRLCAD::Sketch::Nurb::AddControlPointWeight"));
+
+            for (int i = 0; i < m_nurbSegment->c_size; ++i)
+                m_nurbSegment->weights[i] = 1.;
+        }
+
+        m_nurbSegment->weights[m_nurbSegment->c_size - 1] = weight;
     }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
 }
 
 
@@ -782,6 +1243,11 @@ Sketch::Segment* Sketch::Bezier::Clone(void) const {
 }
 
 
+const void* Sketch::Bezier::SegmentInternal(void) const {
+    return m_bezierSegment;
+}
+
+
 Vector2D Sketch::Bezier::StartPoint(void) const {
     assert(m_bezierSegment != 0);
     assert(m_sketch != 0);
@@ -804,7 +1270,7 @@ void Sketch::Bezier::SetStartPoint
 
     if ((m_bezierSegment != 0) && (m_sketch != 0)) {
         if (!BU_SETJUMP)
-            SwapVertex(m_bezierSegment->ctl_points[0], startPoint.coordinates, *m_sketch);
+            SwapVertex(m_bezierSegment->ctl_points[0], startPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -827,7 +1293,7 @@ void Sketch::Bezier::SetEndPoint
 
     if ((m_bezierSegment != 0) && (m_sketch != 0)) {
         if (!BU_SETJUMP)
-            SwapVertex(m_bezierSegment->ctl_points[m_bezierSegment->degree], endPoint.coordinates, *m_sketch);
+            SwapVertex(m_bezierSegment->ctl_points[m_bezierSegment->degree], endPoint.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
         else
             BU_UNSETJUMP;
 
@@ -866,14 +1332,22 @@ void Sketch::Bezier::AddControlPoint
     assert(m_bezierSegment != 0);
     assert(m_sketch != 0);
 
-    size_t vcount = m_sketch->vert_count;
-    size_t ret    = AddToVerts(Point.coordinates, *m_sketch);
+    if (!BU_SETJUMP) {
+        int vertex = AddToVerts(Point.coordinates, *m_sketch, GetIndex(*m_index, *m_sketch));
+
+        UseVertex(vertex, &GetIndex(*m_index, *m_sketch));
+
+        // the first control point doesn't increase the degree
+        if (m_bezierSegment->ctl_points != 0)
+            m_bezierSegment->degree++;
 
-    if (vcount < ret) {
-        m_bezierSegment->degree++;
-        m_bezierSegment->ctl_points                          = static_cast<int*>(bu_realloc(m_bezierSegment->ctl_points, m_bezierSegment->degree * sizeof(int), "BRLCAD::Sketch::Bezier::AddControlPoint"));
-        m_bezierSegment->ctl_points[m_bezierSegment->degree] = static_cast<int>(ret);
+        m_bezierSegment->ctl_points                          = static_cast<int*>(bu_realloc(m_bezierSegment->ctl_points, (m_bezierSegment->degree + 1) * sizeof(int), "BRLCAD::Sketch::Bezier::AddControlPoint"));
+        m_bezierSegment->ctl_points[m_bezierSegment->degree] = vertex;
     }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
 }
 
 
@@ -893,7 +1367,7 @@ void Sketch::Get
             switch (*magic) {
                 case CURVE_LSEG_MAGIC: {
                     line_seg* line = reinterpret_cast<line_seg*>(Internal()->curve.segment[index]);
-                    Line      lineClass(line, const_cast<rt_sketch_internal*>(Internal()));
+                    Line      lineClass(line, const_cast<rt_sketch_internal*>(Internal()), const_cast<SketchIndex**>(&m_index));
 
                     callback(lineClass);
                     }
@@ -901,7 +1375,7 @@ void Sketch::Get
 
                 case CURVE_CARC_MAGIC: {
                     carc_seg*   carc = reinterpret_cast<carc_seg*>(Internal()->curve.segment[index]);
-                    CircularArc arcClass(carc, const_cast<rt_sketch_internal*>(Internal()));
+                    CircularArc arcClass(carc, const_cast<rt_sketch_internal*>(Internal()), const_cast<SketchIndex**>(&m_index));
 
                     callback(arcClass);
                     }
@@ -909,7 +1383,7 @@ void Sketch::Get
 
                 case CURVE_NURB_MAGIC: {
                     nurb_seg* nurb = reinterpret_cast<nurb_seg*>(Internal()->curve.segment[index]);
-                    Nurb      nurbClass(nurb, const_cast<rt_sketch_internal*>(Internal()));
+                    Nurb      nurbClass(nurb, const_cast<rt_sketch_internal*>(Internal()), const_cast<SketchIndex**>(&m_index));
 
                     callback(nurbClass);
                     }
@@ -917,7 +1391,7 @@ void Sketch::Get
 
                 case CURVE_BEZIER_MAGIC: {
                     bezier_seg* bezier = reinterpret_cast<bezier_seg*>(Internal()->curve.segment[index]);
-                    Bezier      bezierClass(bezier, const_cast<rt_sketch_internal*>(Internal()));
+                    Bezier      bezierClass(bezier, const_cast<rt_sketch_internal*>(Internal()), const_cast<SketchIndex**>(&m_index));
 
                     callback(bezierClass);
                     }
@@ -939,7 +1413,7 @@ void Sketch::Get
             switch (*magic) {
                 case CURVE_LSEG_MAGIC: {
                     line_seg* line = reinterpret_cast<line_seg*>(Internal()->curve.segment[index]);
-                    Line      lineClass(line, static_cast<rt_sketch_internal*>(Internal()));
+                    Line      lineClass(line, Internal(), &m_index);
 
                     callback(lineClass);
                     }
@@ -947,7 +1421,7 @@ void Sketch::Get
 
                 case CURVE_CARC_MAGIC: {
                     carc_seg*   carc = reinterpret_cast<carc_seg*>(Internal()->curve.segment[index]);
-                    CircularArc arcClass(carc, static_cast<rt_sketch_internal*>(Internal()));
+                    CircularArc arcClass(carc, Internal(), &m_index);
 
                     callback(arcClass);
                     }
@@ -955,7 +1429,7 @@ void Sketch::Get
 
                 case CURVE_NURB_MAGIC: {
                     nurb_seg* nurb = reinterpret_cast<nurb_seg*>(Internal()->curve.segment[index]);
-                    Nurb      nurbClass(nurb, static_cast<rt_sketch_internal*>(Internal()));
+                    Nurb      nurbClass(nurb, Internal(), &m_index);
 
                     callback(nurbClass);
                     }
@@ -963,7 +1437,7 @@ void Sketch::Get
 
                 case CURVE_BEZIER_MAGIC: {
                     bezier_seg* bezier = reinterpret_cast<bezier_seg*>(Internal()->curve.segment[index]);
-                    Bezier      bezierClass(bezier, static_cast<rt_sketch_internal*>(Internal()));
+                    Bezier      bezierClass(bezier, Internal(), &m_index);
 
                     callback(bezierClass);
                     }
@@ -1009,18 +1483,15 @@ Sketch::Line* Sketch::AppendLine(void) {
 
     if (!BU_SETJUMP) {
         rt_sketch_internal* sketch = Internal();
+        SketchIndex&        index  = Index();
         line_seg*           line   = static_cast<line_seg*>(bu_calloc(1, sizeof(line_seg), "BRLCAD::Sketch::AppendLine"));
         line->magic = CURVE_LSEG_MAGIC;
 
         // start and end point are arbitrary (but valid: index 0)
-        if (sketch->vert_count == 0) {
-            point2d_t zero = {0.};
+        EnsureVertex(*sketch, index);
 
-            AddToVerts(zero, *sketch);
-        }
-
-        AppendSegment(line, sketch);
-        ret = new Line(line, sketch);
+        AppendSegment(line, sketch, index);
+        ret = new Line(line, sketch, &m_index);
     }
     else
         BU_UNSETJUMP;
@@ -1033,25 +1504,22 @@ Sketch::Line* Sketch::AppendLine(void) {
 
 Sketch::Line* Sketch::InsertLine
 (
-        size_t index
+    size_t index
 ) {
     Sketch::Line*       ret    = 0;
     rt_sketch_internal* sketch = Internal();
 
     if (index < sketch->curve.count) {
         if (!BU_SETJUMP) {
-            line_seg* line = static_cast<line_seg*>(bu_calloc(1, sizeof(line_seg), "BRLCAD::Sketch::InsertLine"));
+            SketchIndex& sketchIndex = Index();
+            line_seg*    line        = static_cast<line_seg*>(bu_calloc(1, sizeof(line_seg), "BRLCAD::Sketch::InsertLine"));
             line->magic = CURVE_LSEG_MAGIC;
 
             // start and end point are arbitrary (but valid: index 0)
-            if (sketch->vert_count == 0) {
-                point2d_t zero = {0.};
+            EnsureVertex(*sketch, sketchIndex);
 
-                AddToVerts(zero, *sketch);
-            }
-
-            InsertSegment(line, index, sketch);
-            ret = new Line(line, sketch);
+            InsertSegment(line, index, sketch, sketchIndex);
+            ret = new Line(line, sketch, &m_index);
         }
         else
             BU_UNSETJUMP;
@@ -1068,18 +1536,15 @@ Sketch::CircularArc* Sketch::AppendArc(void) {
 
     if (!BU_SETJUMP) {
         rt_sketch_internal* sketch = Internal();
-        carc_seg* carc =  static_cast<carc_seg*>(bu_calloc(1, sizeof(carc_seg), "BRLCAD::Sketch::AppendArc"));
+        SketchIndex&        index  = Index();
+        carc_seg*           carc   = static_cast<carc_seg*>(bu_calloc(1, sizeof(carc_seg), "BRLCAD::Sketch::AppendArc"));
         carc->magic = CURVE_CARC_MAGIC;
 
         // start and end point are arbitrary (but valid: index 0)
-        if (sketch->vert_count == 0) {
-            point2d_t zero = {0.};
-
-            AddToVerts(zero, *sketch);
-        }
+        EnsureVertex(*sketch, index);
 
-        AppendSegment(carc, sketch);
-        ret = new CircularArc(carc, sketch);
+        AppendSegment(carc, sketch, index);
+        ret = new CircularArc(carc, sketch, &m_index);
     }
     else
         BU_UNSETJUMP;
@@ -1092,25 +1557,22 @@ Sketch::CircularArc* Sketch::AppendArc(void) {
 
 Sketch::CircularArc* Sketch::InsertArc
 (
-        size_t index
+    size_t index
 ) {
     Sketch::CircularArc* ret    = 0;
     rt_sketch_internal*  sketch = Internal();
 
     if (index < sketch->curve.count) {
         if (!BU_SETJUMP) {
-            carc_seg* carc = static_cast<carc_seg*>(bu_calloc(1, sizeof(carc_seg), "BRLCAD::Sketch::InsertArc"));
+            SketchIndex& sketchIndex = Index();
+            carc_seg*    carc        = static_cast<carc_seg*>(bu_calloc(1, sizeof(carc_seg), "BRLCAD::Sketch::InsertArc"));
             carc->magic = CURVE_CARC_MAGIC;
 
             // start and end point are arbitrary (but valid: index 0)
-            if (sketch->vert_count == 0) {
-                point2d_t zero = {0.};
+            EnsureVertex(*sketch, sketchIndex);
 
-                AddToVerts(zero, *sketch);
-            }
-
-            InsertSegment(carc, index, sketch);
-            ret = new CircularArc(carc, sketch);
+            InsertSegment(carc, index, sketch, sketchIndex);
+            ret = new CircularArc(carc, sketch, &m_index);
         }
         else
             BU_UNSETJUMP;
@@ -1127,19 +1589,15 @@ Sketch::Nurb* Sketch::AppendNurb(void) {
 
     if (!BU_SETJUMP) {
         rt_sketch_internal* sketch = Internal();
+        SketchIndex&        index  = Index();
         nurb_seg*           nurb   = static_cast<nurb_seg*>(bu_calloc(1, sizeof(nurb_seg), "BRLCAD::Sketch::AppendNurb"));
         nurb->magic = CURVE_NURB_MAGIC;
 
         // start and end point are arbitrary (but valid: index 0)
-        if (sketch->vert_count == 0) {
-            point2d_t zero = {0.};
-
-            AddToVerts(zero, *sketch);
-        }
-
-        AppendSegment(nurb, sketch);
-        ret = new Nurb(nurb, sketch);
+        EnsureVertex(*sketch, index);
 
+        AppendSegment(nurb, sketch, index);
+        ret = new Nurb(nurb, sketch, &m_index);
     }
     else
         BU_UNSETJUMP;
@@ -1152,25 +1610,22 @@ Sketch::Nurb* Sketch::AppendNurb(void) {
 
 Sketch::Nurb* Sketch::InsertNurb
 (
-        size_t index
+    size_t index
 ) {
     Sketch::Nurb*       ret    = 0;
     rt_sketch_internal* sketch = Internal();
 
     if (index < sketch->curve.count) {
         if (!BU_SETJUMP) {
-            nurb_seg* nurb = static_cast<nurb_seg*>(bu_calloc(1, sizeof(nurb_seg), "BRLCAD::Sketch::InsertNurb"));
+            SketchIndex& sketchIndex = Index();
+            nurb_seg*    nurb        = static_cast<nurb_seg*>(bu_calloc(1, sizeof(nurb_seg), "BRLCAD::Sketch::InsertNurb"));
             nurb->magic = CURVE_NURB_MAGIC;
 
             // start and end point are arbitrary (but valid: index 0)
-            if (sketch->vert_count == 0) {
-                point2d_t zero = {0.};
-
-                AddToVerts(zero, *sketch);
-            }
+            EnsureVertex(*sketch, sketchIndex);
 
-            InsertSegment(nurb, index, sketch);
-            ret = new Nurb(nurb, sketch);
+            InsertSegment(nurb, index, sketch, sketchIndex);
+            ret = new Nurb(nurb, sketch, &m_index);
         }
         else
             BU_UNSETJUMP;
@@ -1187,18 +1642,15 @@ Sketch::Bezier* Sketch::AppendBezier(void) {
 
     if (!BU_SETJUMP) {
         rt_sketch_internal* sketch = Internal();
+        SketchIndex&        index  = Index();
         bezier_seg*         bezier = static_cast<bezier_seg*>(bu_calloc(1, sizeof(bezier_seg), "BRLCAD::Sketch::AppendBezier"));
         bezier->magic = CURVE_BEZIER_MAGIC;
 
         // start and end point are arbitrary (but valid: index 0)
-        if (sketch->vert_count == 0) {
-            point2d_t zero = {0.};
+        EnsureVertex(*sketch, index);
 
-            AddToVerts(zero, *sketch);
-        }
-
-        AppendSegment(bezier, sketch);
-        ret = new Bezier(bezier, sketch);
+        AppendSegment(bezier, sketch, index);
+        ret = new Bezier(bezier, sketch, &m_index);
     }
     else
         BU_UNSETJUMP;
@@ -1218,18 +1670,15 @@ Sketch::Bezier* Sketch::InsertBezier
 
     if (index < sketch->curve.count) {
         if (!BU_SETJUMP) {
-            bezier_seg* bezier = static_cast<bezier_seg*>(bu_calloc(1, sizeof(bezier_seg), "BRLCAD::Sketch::InsertBezier"));
+            SketchIndex& sketchIndex = Index();
+            bezier_seg*  bezier      = static_cast<bezier_seg*>(bu_calloc(1, sizeof(bezier_seg), "BRLCAD::Sketch::InsertBezier"));
             bezier->magic = CURVE_BEZIER_MAGIC;
 
             // start and end point are arbitrary (but valid: index 0)
-            if (sketch->vert_count == 0) {
-                point2d_t zero = {0.};
-
-                AddToVerts(zero, *sketch);
-            }
+            EnsureVertex(*sketch, sketchIndex);
 
-            InsertSegment(bezier, index, sketch);
-            ret = new Bezier(bezier, sketch);
+            InsertSegment(bezier, index, sketch, sketchIndex);
+            ret = new Bezier(bezier, sketch, &m_index);
         }
         else
             BU_UNSETJUMP;
@@ -1241,19 +1690,235 @@ Sketch::Bezier* Sketch::InsertBezier
 }
 
 
+/// welds the vertices of a bulk append with the existing ones
+/** Returns a map from the given to the vertex indices of the sketch, to be freed with bu_free(). */
+static int* AddToVerts
+(
+    const double*       vertices,
+    size_t              numberOfVertices,
+    rt_sketch_internal& sketch,
+    SketchIndex&        index
+) {
+    int* ret = static_cast<int*>(bu_malloc((numberOfVertices > 0 ? numberOfVertices : 1) * sizeof(int), "BRLCAD sketch interface AddToVerts: vertexMap"));
+
+    for (size_t i = 0; i < numberOfVertices; ++i) {
+        point2d_t point = {vertices[2 * i], vertices[2 * i + 1]};
+
+        ret[i] = AddToVerts(point, sketch, index);
+    }
+
+    return ret;
+}
+
+
+void Sketch::AppendLines
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    lines,
+    size_t        numberOfLines
+) {
+    if (!BU_SETJUMP) {
+        rt_sketch_internal* sketch    = Internal();
+        SketchIndex&        index     = Index();
+        int*                vertexMap = AddToVerts(vertices, numberOfVertices, *sketch, index);
+
+        ReserveSegments(sketch->curve.count + numberOfLines, sketch, index);
+
+        for (size_t i = 0; i < numberOfLines; ++i) {
+            assert((lines[2 * i] >= 0) && (static_cast<size_t>(lines[2 * i]) < numberOfVertices));
+            assert((lines[2 * i + 1] >= 0) && (static_cast<size_t>(lines[2 * i + 1]) < numberOfVertices));
+
+            line_seg* line = static_cast<line_seg*>(bu_calloc(1, sizeof(line_seg), "BRLCAD::Sketch::AppendLines"));
+            line->magic = CURVE_LSEG_MAGIC;
+            line->start = vertexMap[lines[2 * i]];
+            line->end   = vertexMap[lines[2 * i + 1]];
+
+            AppendSegment(line, sketch, index);
+        }
+
+        bu_free(vertexMap, "BRLCAD::Sketch::AppendLines: vertexMap");
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+}
+
+
+void Sketch::AppendArcs
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    arcs,
+    const double* radii,
+    size_t        numberOfArcs,
+    const bool*   centersAreLeft,
+    const bool*   clockwiseOriented,
+    const int*    centers
+) {
+    if (!BU_SETJUMP) {
+        rt_sketch_internal* sketch    = Internal();
+        SketchIndex&        index     = Index();
+        int*                vertexMap = AddToVerts(vertices, numberOfVertices, *sketch, index);
+
+        ReserveSegments(sketch->curve.count + numberOfArcs, sketch, index);
+
+        for (size_t i = 0; i < numberOfArcs; ++i) {
+            assert((arcs[2 * i] >= 0) && (static_cast<size_t>(arcs[2 * i]) < numberOfVertices));
+            assert((arcs[2 * i + 1] >= 0) && (static_cast<size_t>(arcs[2 * i + 1]) < numberOfVertices));
+
+            carc_seg* carc = static_cast<carc_seg*>(bu_calloc(1, sizeof(carc_seg), "BRLCAD::Sketch::AppendArcs"));
+            carc->magic          = CURVE_CARC_MAGIC;
+            carc->start          = vertexMap[arcs[2 * i]];
+            carc->end            = vertexMap[arcs[2 * i + 1]];
+            carc->radius         = radii[i];
+            carc->center_is_left = ((centersAreLeft != 0) && centersAreLeft[i]) ? 1 : 0;
+            carc->orientation    = ((clockwiseOriented != 0) && clockwiseOriented[i]) ? 1 : 0;
+
+            // without centers like in AppendArc()
+            if (centers != 0) {
+                assert((centers[i] >= 0) && (static_cast<size_t>(centers[i]) < numberOfVertices));
+
+                carc->center = vertexMap[centers[i]];
+            }
+
+            AppendSegment(carc, sketch, index);
+        }
+
+        bu_free(vertexMap, "BRLCAD::Sketch::AppendArcs: vertexMap");
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+}
+
+
+void Sketch::AppendBeziers
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    controlPoints,
+    const size_t* degrees,
+    size_t        numberOfBeziers
+) {
+    if (!BU_SETJUMP) {
+        rt_sketch_internal* sketch    = Internal();
+        SketchIndex&        index     = Index();
+        int*                vertexMap = AddToVerts(vertices, numberOfVertices, *sketch, index);
+        size_t              offset    = 0;
+
+        ReserveSegments(sketch->curve.count + numberOfBeziers, sketch, index);
+
+        for (size_t i = 0; i < numberOfBeziers; ++i) {
+            bezier_seg* bezier = static_cast<bezier_seg*>(bu_calloc(1, sizeof(bezier_seg), "BRLCAD::Sketch::AppendBeziers"));
+            bezier->magic      = CURVE_BEZIER_MAGIC;
+            bezier->degree     = static_cast<int>(degrees[i]);
+            bezier->ctl_points = static_cast<int*>(bu_malloc((degrees[i] + 1) * sizeof(int), "BRLCAD::Sketch::AppendBeziers: ctl_points"));
+
+            for (size_t j = 0; j <= degrees[i]; ++j) {
+                assert((controlPoints[offset + j] >= 0) && (static_cast<size_t>(controlPoints[offset + j]) < numberOfVertices));
+
+                bezier->ctl_points[j] = vertexMap[controlPoints[offset + j]];
+            }
+
+            offset += degrees[i] + 1;
+
+            AppendSegment(bezier, sketch, index);
+        }
+
+        bu_free(vertexMap, "BRLCAD::Sketch::AppendBeziers: vertexMap");
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+}
+
+
+void Sketch::AppendNurbs
+(
+    const double* vertices,
+    size_t        numberOfVertices,
+    const int*    controlPoints,
+    const size_t* numberOfControlPoints,
+    const size_t* orders,
+    const double* knots,
+    const size_t* numberOfKnots,
+    size_t        numberOfNurbs,
+    const double* weights
+) {
+    if (!BU_SETJUMP) {
+        rt_sketch_internal* sketch      = Internal();
+        SketchIndex&        index       = Index();
+        int*                vertexMap   = AddToVerts(vertices, numberOfVertices, *sketch, index);
+        size_t              pointOffset = 0;
+        size_t              knotOffset  = 0;
+
+        ReserveSegments(sketch->curve.count + numberOfNurbs, sketch, index);
+
+        for (size_t i = 0; i < numberOfNurbs; ++i) {
+            nurb_seg* nurb = static_cast<nurb_seg*>(bu_calloc(1, sizeof(nurb_seg), "BRLCAD::Sketch::AppendNurbs"));
+            nurb->magic      = CURVE_NURB_MAGIC;
+            nurb->order      = static_cast<int>(orders[i]);
+            nurb->pt_type    = (weights != 0) ? RT_NURB_MAKE_PT_TYPE(3, RT_NURB_PT_UV, RT_NURB_PT_RATIONAL) : RT_NURB_MAKE_PT_TYPE(2, RT_NURB_PT_UV, RT_NURB_PT_NONRAT);
+            nurb->c_size     = static_cast<int>(numberOfControlPoints[i]);
+            nurb->ctl_points = static_cast<int*>(bu_malloc(numberOfControlPoints[i] * sizeof(int), "BRLCAD::Sketch::AppendNurbs: ctl_points"));
+
+            for (size_t j = 0; j < numberOfControlPoints[i]; ++j) {
+                assert((controlPoints[pointOffset + j] >= 0) && (static_cast<size_t>(controlPoints[pointOffset + j]) < numberOfVertices));
+
+                nurb->ctl_points[j] = vertexMap[controlPoints[pointOffset + j]];
+            }
+
+            if (weights != 0) {
+                nurb->weights = static_cast<fastf_t*>(bu_malloc(numberOfControlPoints[i] * sizeof(fastf_t), "BRLCAD::Sketch::AppendNurbs: weights"));
+
+                for (size_t j = 0; j < numberOfControlPoints[i]; ++j)
+                    nurb->weights[j] = weights[pointOffset + j];
+            }
+
+            nurb->k.magic  = NMG_KNOT_VECTOR_MAGIC;
+            nurb->k.k_size = static_cast<int>(numberOfKnots[i]);
+            nurb->k.knots  = static_cast<fastf_t*>(bu_malloc(numberOfKnots[i] * sizeof(fastf_t), "BRLCAD::Sketch::AppendNurbs: knots"));
+
+            for (size_t j = 0; j < numberOfKnots[i]; ++j)
+                nurb->k.knots[j] = knots[knotOffset + j];
+
+            pointOffset += numberOfControlPoints[i];
+            knotOffset  += numberOfKnots[i];
+
+            AppendSegment(nurb, sketch, index);
+        }
+
+        bu_free(vertexMap, "BRLCAD::Sketch::AppendNurbs: vertexMap");
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+}
+
+
 static void FreeSegment
 (
     size_t              index,
-    rt_sketch_internal& sketch
+    rt_sketch_internal& sketch,
+    SketchIndex&        sketchIndex
 ){
+    // the vertices remain until the next compaction
+    if (!sketchIndex.usageValid)
+        BuildVertexUsage(sketchIndex, sketch);
+
+    ForEachVertexReference(sketch.curve.segment[index], ReleaseVertex, &sketchIndex);
+
     const uint32_t *magic = static_cast<uint32_t*>(sketch.curve.segment[index]);
 
     switch (*magic) {
         case CURVE_LSEG_MAGIC: {
             line_seg* line = static_cast<line_seg*>(sketch.curve.segment[index]);
 
-            RemoveFromVerts(line->start, sketch);
-            RemoveFromVerts(line->end, sketch);
             bu_free(line,"BRLCAD sketch interface FreeSegment: line");
         }
         break;
@@ -1261,8 +1926,6 @@ static void FreeSegment
         case CURVE_CARC_MAGIC: {
             carc_seg* carc = static_cast<carc_seg*>(sketch.curve.segment[index]);
 
-            RemoveFromVerts(carc->start, sketch);
-            RemoveFromVerts(carc->end, sketch);
             bu_free(carc,"BRLCAD sketch interface FreeSegment: carc");
         }
         break;
@@ -1270,12 +1933,15 @@ static void FreeSegment
         case CURVE_NURB_MAGIC: {
             nurb_seg* nurb = static_cast<nurb_seg*>(sketch.curve.segment[index]);
 
-            for(int i = 0; i < nurb->c_size; ++i) {
-                RemoveFromVerts(nurb->ctl_points[i], sketch);
-            }
+            if (nurb->k.knots != 0)
+                bu_free(nurb->k.knots,"BRLCAD sketch interface FreeSegment: nurb.k.knots");
+
+            if (nurb->ctl_points != 0)
+                bu_free(nurb->ctl_points,"BRLCAD sketch interface FreeSegment: nurb.ctl_points");
+
+            if (nurb->weights != 0)
+                bu_free(nurb->weights,"BRLCAD sketch interface FreeSegment: nurb.weights");
 
-            bu_free(nurb->ctl_points,"BRLCAD sketch interface FreeSegment: nurb.ctl_points");
-            bu_free(nurb->weights,"BRLCAD sketch interface FreeSegment: nurb.weights");
             bu_free(nurb,"BRLCAD sketch interface FreeSegment: nurb");
         }
         break;
@@ -1283,11 +1949,9 @@ static void FreeSegment
         case CURVE_BEZIER_MAGIC: {
             bezier_seg* bezier = static_cast<bezier_seg*>(sketch.curve.segment[index]);
 
-            for(int i = 0; i < bezier->degree - 1; ++i) {
-                RemoveFromVerts(bezier->ctl_points[i], sketch);
-            }
+            if (bezier->ctl_points != 0)
+                bu_free(bezier->ctl_points,"BRLCAD sketch interface FreeSegment: bezier.ctl_points");
 
-            bu_free(bezier->ctl_points,"BRLCAD sketch interface FreeSegment: bezier.ctl_points");
             bu_free(bezier,"BRLCAD sketch interface FreeSegment: bezier");
         }
     }
@@ -1301,25 +1965,42 @@ void Sketch::DeleteSegment
     assert(index < Internal()->curve.count);
 
     if(index < Internal()->curve.count) {
-        int    tempItr = 0;
-        void** temp    = static_cast<void**>(bu_calloc(Internal()->curve.count - 1, sizeof(void*), "BRLCAD::Sketch::DeleteSegment"));
+        if (!BU_SETJUMP) {
+            rt_sketch_internal* sketch      = Internal();
+            SketchIndex&        sketchIndex = Index();
 
-        for(int i = 0; i < Internal()->curve.count; ++i) {
-            if(i != index) {
-                temp[tempItr] = Internal()->curve.segment[i];
-                tempItr++;
-            }
-        }
+            FreeSegment(index, *sketch, sketchIndex);
 
-        FreeSegment(index, *Internal());
+            // the arrays keep their capacity
+            memmove(sketch->curve.reverse + index, sketch->curve.reverse + index + 1, (sketch->curve.count - index - 1) * sizeof(int));
+            memmove(sketch->curve.segment + index, sketch->curve.segment + index + 1, (sketch->curve.count - index - 1) * sizeof(void*));
+            sketch->curve.count--;
 
-        bu_free(Internal()->curve.segment, "BRLCAD::Sketch::DeleteSegment");
-        Internal()->curve.segment = temp;
-        Internal()->curve.count--;
+            CompactIfSparse(*sketch, sketchIndex);
+        }
+        else
+            BU_UNSETJUMP;
+
+        BU_UNSETJUMP;
     }
 }
 
 
+size_t Sketch::NumberOfVertices(void) const {
+    return Internal()->vert_count;
+}
+
+
+void Sketch::Compact(void) {
+    if (!BU_SETJUMP)
+        CompactVertices(*Internal(), Index());
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+}
+
+
 size_t Sketch::NumberOfSegments(void) const {
     return Internal()->curve.count;
 }
@@ -1436,4 +2117,9 @@ Sketch::Sketch
     directory*      pDir,
     rt_db_internal* ip,
     db_i*           dbip
-) : Object(resp, pDir, ip, dbip), m_internalp(0) {}
+) : Object(resp, pDir, ip, dbip), m_internalp(0), m_index(0) {}
+
+
+SketchIndex& Sketch::Index(void) {
+    return GetIndex(m_index, *Internal());
+}
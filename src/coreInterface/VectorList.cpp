@@ -845,6 +845,148 @@ VectorList::ModelSpace::ModelSpace
 //
 // BRLCAD::VectorList
 //
+static unsigned char ElementTypeOf
+(
+    int command
+) {
+    switch (command) {
+        case BV_VLIST_LINE_MOVE:     return VectorList::Element::LineMove;
+        case BV_VLIST_LINE_DRAW:     return VectorList::Element::LineDraw;
+        case BV_VLIST_POLY_START:    return VectorList::Element::PolygonStart;
+        case BV_VLIST_POLY_MOVE:     return VectorList::Element::PolygonMove;
+        case BV_VLIST_POLY_DRAW:     return VectorList::Element::PolygonDraw;
+        case BV_VLIST_POLY_END:      return VectorList::Element::PolygonEnd;
+        case BV_VLIST_POLY_VERTNORM: return VectorList::Element::PolygonVertexNormal;
+        case BV_VLIST_TRI_START:     return VectorList::Element::TriangleStart;
+        case BV_VLIST_TRI_MOVE:      return VectorList::Element::TriangleMove;
+        case BV_VLIST_TRI_DRAW:      return VectorList::Element::TriangleDraw;
+        case BV_VLIST_TRI_END:       return VectorList::Element::TriangleEnd;
+        case BV_VLIST_TRI_VERTNORM:  return VectorList::Element::TriangleVertexNormal;
+        case BV_VLIST_POINT_DRAW:    return VectorList::Element::PointDraw;
+        case BV_VLIST_POINT_SIZE:    return VectorList::Element::PointSize;
+        case BV_VLIST_LINE_WIDTH:    return VectorList::Element::LineWidth;
+        case BV_VLIST_DISPLAY_MAT:   return VectorList::Element::DisplaySpace;
+        case BV_VLIST_MODEL_MAT:     return VectorList::Element::ModelSpace;
+        default:                     return 255;
+    }
+}
+
+
+/// one pass over the chunks, returns the number of line strips
+template<typename T>
+static size_t ExportVectorList
+(
+    bu_list*       vlist,
+    T*             positions,
+    unsigned char* types,
+    size_t*        stripStarts,
+    size_t*        stripLengths
+) {
+    size_t    numberOfStrips = 0;
+    size_t    elementIndex   = 0;
+    bool      inStrip        = false;
+    bv_vlist* chunk;
+
+    for (BU_LIST_FOR(chunk, bv_vlist, vlist)) {
+        for (size_t i = 0; i < chunk->nused; ++i) {
+            const int command = chunk->cmd[i];
+
+            if (positions != 0) {
+                positions[3 * elementIndex]     = static_cast<T>(chunk->pt[i][X]);
+                positions[3 * elementIndex + 1] = static_cast<T>(chunk->pt[i][Y]);
+                positions[3 * elementIndex + 2] = static_cast<T>(chunk->pt[i][Z]);
+            }
+
+            if (types != 0)
+                types[elementIndex] = ElementTypeOf(command);
+
+            if ((command == BV_VLIST_LINE_MOVE) || ((command == BV_VLIST_LINE_DRAW) && !inStrip)) {
+                if (stripStarts != 0)
+                    stripStarts[numberOfStrips] = elementIndex;
+
+                if (stripLengths != 0)
+                    stripLengths[numberOfStrips] = 1;
+
+                ++numberOfStrips;
+                inStrip = true;
+            }
+            else if (command == BV_VLIST_LINE_DRAW) {
+                if (stripLengths != 0)
+                    ++stripLengths[numberOfStrips - 1];
+            }
+            else
+                inStrip = false;
+
+            ++elementIndex;
+        }
+    }
+
+    return numberOfStrips;
+}
+
+
+/// appends \a numberOfPoints points chunk by chunk, the first one with \a firstCommand, all others with \a command
+static void AppendPoints
+(
+    bu_list*      vlist,
+    const double* points,
+    size_t        numberOfPoints,
+    int           firstCommand,
+    int           command
+) {
+    size_t i = 0;
+
+    while (i < numberOfPoints) {
+        bv_vlist* chunk = BU_LIST_LAST(bv_vlist, vlist);
+
+        if (BU_LIST_IS_HEAD(chunk, vlist) || (chunk->nused >= BV_VLIST_CHUNK)) {
+            BV_GET_VLIST(&RTG.rtg_vlfree, chunk);
+            BU_LIST_INSERT(vlist, &(chunk->l));
+        }
+
+        size_t count = BV_VLIST_CHUNK - chunk->nused;
+
+        if (count > numberOfPoints - i)
+            count = numberOfPoints - i;
+
+        for (size_t j = 0; j < count; ++j) {
+            VMOVE(chunk->pt[chunk->nused + j], points + 3 * (i + j));
+            chunk->cmd[chunk->nused + j] = command;
+        }
+
+        if (i == 0)
+            chunk->cmd[chunk->nused] = firstCommand;
+
+        chunk->nused += count;
+        i            += count;
+    }
+}
+
+
+static void PolygonNormal
+(
+    const double* points,
+    size_t        numberOfPoints,
+    vect_t        normal
+) {
+    VSETALL(normal, 0.);
+
+    for (size_t i = 0; i < numberOfPoints; ++i) {
+        const double* current = points + 3 * i;
+        const double* next    = points + 3 * ((i + 1) % numberOfPoints);
+
+        normal[X] += (current[Y] - next[Y]) * (current[Z] + next[Z]);
+        normal[Y] += (current[Z] - next[Z]) * (current[X] + next[X]);
+        normal[Z] += (current[X] - next[X]) * (current[Y] + next[Y]);
+    }
+
+    double length = MAGNITUDE(normal);
+
+    if (length > SMALL_FASTF)
+        VSCALE(normal, normal, 1. / length);
+}
+
+
 VectorList::VectorList(void) {
     m_vlist = new bu_list;
     BU_LIST_INIT(m_vlist);
@@ -1247,6 +1389,54 @@ void VectorList::Iterate
 }
 
 
+size_t VectorList::NumberOfElements(void) const {
+    size_t ret = 0;
+
+    if (m_vlist != 0) {
+        bv_vlist* chunk;
+
+        for (BU_LIST_FOR(chunk, bv_vlist, m_vlist))
+            ret += chunk->nused;
+    }
+
+    return ret;
+}
+
+
+size_t VectorList::NumberOfLineStrips(void) const {
+    size_t ret = 0;
+
+    if (m_vlist != 0)
+        ret = ExportVectorList<double>(m_vlist, 0, 0, 0, 0);
+
+    return ret;
+}
+
+
+void VectorList::Export
+(
+    double*        positions,
+    unsigned char* types,
+    size_t*        stripStarts,
+    size_t*        stripLengths
+) const {
+    if (m_vlist != 0)
+        ExportVectorList(m_vlist, positions, types, stripStarts, stripLengths);
+}
+
+
+void VectorList::Export
+(
+    float*         positions,
+    unsigned char* types,
+    size_t*        stripStarts,
+    size_t*        stripLengths
+) const {
+    if (m_vlist != 0)
+        ExportVectorList(m_vlist, positions, types, stripStarts, stripLengths);
+}
+
+
 bool VectorList::Append
 (
     const Element& element
@@ -1382,6 +1572,75 @@ bool VectorList::Append
 }
 
 
+bool VectorList::AppendLines
+(
+    const double* points,
+    const size_t* stripLengths,
+    size_t        numberOfStrips
+) {
+    bool ret = false;
+
+    if (!BU_SETJUMP) {
+        const double* strip = points;
+
+        for (size_t i = 0; i < numberOfStrips; ++i) {
+            AppendPoints(m_vlist, strip, stripLengths[i], BV_VLIST_LINE_MOVE, BV_VLIST_LINE_DRAW);
+            strip += 3 * stripLengths[i];
+        }
+
+        ret = true;
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+
+    return ret;
+}
+
+
+bool VectorList::AppendPolygons
+(
+    const double* points,
+    const size_t* polygonLengths,
+    size_t        numberOfPolygons,
+    const double* normals
+) {
+    bool ret = false;
+
+    if (!BU_SETJUMP) {
+        const double* polygon = points;
+
+        for (size_t i = 0; i < numberOfPolygons; ++i) {
+            const size_t numberOfPoints = polygonLengths[i];
+
+            if (numberOfPoints > 0) {
+                vect_t normal;
+
+                if (normals != 0)
+                    VMOVE(normal, normals + 3 * i);
+                else
+                    PolygonNormal(polygon, numberOfPoints, normal);
+
+                RT_ADD_VLIST(m_vlist, normal, BV_VLIST_POLY_START);
+                AppendPoints(m_vlist, polygon, numberOfPoints, BV_VLIST_POLY_MOVE, BV_VLIST_POLY_DRAW);
+                RT_ADD_VLIST(m_vlist, polygon, BV_VLIST_POLY_END);
+            }
+
+            polygon += 3 * numberOfPoints;
+        }
+
+        ret = true;
+    }
+    else
+        BU_UNSETJUMP;
+
+    BU_UNSETJUMP;
+
+    return ret;
+}
+
+
 void VectorList::Clear(void) {
     RT_FREE_VLIST(m_vlist);
 }
@@ -278,6 +278,40 @@ bool testPipeDeleteControlPointMethod()
 		EQUAL(bendRadius1, bendRadius2)));
 }
 
+bool testPipeControlPointIterator()
+{
+    Pipe p1 = makePipe();
+    Pipe p2 = makePipe();
+    size_t index = 0;
+    bool sameControlPoints = true;
+    for (Pipe::ControlPointIterator it = p1.FirstControlPoint(); it; ++it) {
+	const Vector3D point1 = (*it).Point();
+	const Vector3D point2 = p2.GetControlPoint(index).Point();
+	if (!VECTOR3D_EQUAL(point1, point2))
+	    sameControlPoints = false;
+	++index;
+    }
+    return(sameControlPoints && (index == p1.NumberOfControlPoints()));
+}
+
+bool testPipeSetControlPointsMethod()
+{
+    Pipe p = makePipe();
+    const double points[] = {0.0, 0.0, 0.0, 0.0, 0.0, 10.0, 10.0, 0.0, 10.0};
+    const double innerDiameters[] = {1.0, 1.0, 1.0};
+    const double outerDiameters[] = {2.0, 2.0, 2.0};
+    const double bendRadii[] = {2.0, 2.0, 2.0};
+    p.SetControlPoints(points, innerDiameters, outerDiameters, bendRadii, 3);
+    p.InsertControlPoint(1, Vector3D(0.0, 0.0, 5.0), 1.0, 2.0, 2.0);
+    p.DeleteControlPoint(3);
+    const Vector3D point1 = p.GetControlPoint(1).Point();
+    const Vector3D point2 = p.GetControlPoint(2).Point();
+    return((p.NumberOfControlPoints() == 3) &&
+	    VECTOR3D_EQUAL(point1, Vector3D(0.0, 0.0, 5.0)) &&
+	    VECTOR3D_EQUAL(point2, Vector3D(0.0, 0.0, 10.0)) &&
+	    p.IsValid());
+}
+
 bool testPipeCloneMethod()
 {
     Pipe p = makePipe();
@@ -305,6 +339,8 @@ void test_pipe(Database& database)
 	ADD_TEST(testControlPointSetOuterDiameterMethod(), allPipeTestsPassed);
 	ADD_TEST(testControlPointSetBendRadiusMethod(), allPipeTestsPassed);
 	ADD_TEST(testPipeDeleteControlPointMethod(), allPipeTestsPassed);
+	ADD_TEST(testPipeControlPointIterator(), allPipeTestsPassed);
+	ADD_TEST(testPipeSetControlPointsMethod(), allPipeTestsPassed);
 	ADD_TEST(testPipeCloneMethod(), allPipeTestsPassed);
     } else {
 	std::cout << "Default Pipe is not valid" << std::endl;
@@ -51,6 +51,8 @@ int main
 		test_sphere(database);
 		test_cone(database);
 		test_pipe(database);
+		test_sketch(database);
+		test_transaction(database);
 	    } else {
 		std::cout << "Could not load file: " << argv[1] << std::endl;
 		ret = 2;
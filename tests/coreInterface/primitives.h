@@ -33,7 +33,9 @@ void test_cone(BRLCAD::Database& database);
 void test_ellipsoid(BRLCAD::Database& database);
 void test_halfspace(BRLCAD::Database& database);
 void test_pipe(BRLCAD::Database& database);
+void test_sketch(BRLCAD::Database& database);
 void test_sphere(BRLCAD::Database& database);
+void test_transaction(BRLCAD::Database& database);
 
 
 #endif // PRIMITIVES_H
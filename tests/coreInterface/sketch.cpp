@@ -0,0 +1,244 @@
+/*                      S K E T C H . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2015 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file sketch.cpp
+ *
+ * BRL-CAD core C++ interface :
+ *		Unit tests for Sketch class implementation
+ *
+ */
+
+#include <iostream>
+#include <brlcad/Sketch.h>
+#include "bn.h"
+#include "primitives.h"
+using namespace BRLCAD;
+
+#define VECTOR2D_EQUAL(a, b) V2NEAR_EQUAL(a.coordinates, b.coordinates, BN_TOL_DIST)
+
+#define ADD_TEST(expression, allTestsPassed)    \
+    if (!expression) {    \
+	std::cout << "Failed test: " << #expression << std::endl;    \
+	allTestsPassed = false;    \
+    } else {    \
+	std::cout << "Passed test: " << #expression << std::endl;    \
+    }
+
+bool segmentHasPoints(const Sketch& s, size_t index, const Vector2D& startPoint, const Vector2D& endPoint)
+{
+    Sketch::Segment *segment = s.Get(index);
+    bool ret = false;
+    if (segment != 0) {
+	ret = VECTOR2D_EQUAL(segment->StartPoint(), startPoint) &&
+	      VECTOR2D_EQUAL(segment->EndPoint(), endPoint);
+	segment->Destroy();
+    }
+    return ret;
+}
+
+bool segmentIsReversed(const Sketch& s, size_t index)
+{
+    Sketch::Segment *segment = s.Get(index);
+    bool ret = false;
+    if (segment != 0) {
+	ret = segment->Reverse();
+	segment->Destroy();
+    }
+    return ret;
+}
+
+bool testSketchAppendLinesWelding()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 0.0, 1.0, 0.0, 1.0, 1.0};
+    const int lines[] = {0, 1, 2, 3};
+    s.AppendLines(vertices, 4, lines, 2);
+    /* the second call shares all of its vertices with the first one */
+    const double moreVertices[] = {1.0, 1.0, 0.0, 0.0};
+    const int moreLines[] = {0, 1};
+    s.AppendLines(moreVertices, 2, moreLines, 1);
+    return((s.NumberOfSegments() == 3) &&
+	    (s.NumberOfVertices() == 3) &&
+	    segmentHasPoints(s, 0, Vector2D(0.0, 0.0), Vector2D(1.0, 0.0)) &&
+	    segmentHasPoints(s, 1, Vector2D(1.0, 0.0), Vector2D(1.0, 1.0)) &&
+	    segmentHasPoints(s, 2, Vector2D(1.0, 1.0), Vector2D(0.0, 0.0)));
+}
+
+bool testSketchAppendArcsMethod()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 0.0, 0.0, 1.0};
+    const int arcs[] = {1, 2};
+    const double radii[] = {1.0};
+    const int centers[] = {0};
+    s.AppendArcs(vertices, 3, arcs, radii, 1, 0, 0, centers);
+    Sketch::CircularArc *arc = dynamic_cast<Sketch::CircularArc *>(s.Get(0));
+    bool ret = false;
+    if (arc != 0) {
+	const Vector3D center = arc->Center();
+	ret = EQUAL(center.coordinates[0], 0.0) &&
+	      EQUAL(center.coordinates[1], 0.0) &&
+	      EQUAL(arc->Radius(), 1.0) &&
+	      VECTOR2D_EQUAL(arc->StartPoint(), Vector2D(1.0, 0.0)) &&
+	      VECTOR2D_EQUAL(arc->EndPoint(), Vector2D(0.0, 1.0));
+	arc->Destroy();
+    }
+    return ret;
+}
+
+bool testSketchAppendBeziersMethod()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 1.0, 2.0, 0.0, 3.0, 1.0};
+    const int controlPoints[] = {0, 1, 2, 2, 3};
+    const size_t degrees[] = {2, 1};
+    s.AppendBeziers(vertices, 4, controlPoints, degrees, 2);
+    Sketch::Bezier *bezier = dynamic_cast<Sketch::Bezier *>(s.Get(0));
+    bool ret = false;
+    if (bezier != 0) {
+	ret = (bezier->Degree() == 2) &&
+	      VECTOR2D_EQUAL(bezier->ControlPoint(1), Vector2D(1.0, 1.0));
+	bezier->Destroy();
+    }
+    return(ret &&
+	    (s.NumberOfSegments() == 2) &&
+	    (s.NumberOfVertices() == 4) &&
+	    segmentHasPoints(s, 1, Vector2D(2.0, 0.0), Vector2D(3.0, 1.0)));
+}
+
+bool testSketchAppendNurbsMethod()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 1.0, 2.0, 0.0};
+    const int controlPoints[] = {0, 1, 2};
+    const size_t numberOfControlPoints[] = {3};
+    const size_t orders[] = {3};
+    const double knots[] = {0.0, 0.0, 0.0, 1.0, 1.0, 1.0};
+    const size_t numberOfKnots[] = {6};
+    s.AppendNurbs(vertices, 3, controlPoints, numberOfControlPoints, orders, knots, numberOfKnots, 1);
+    Sketch::Nurb *nurb = dynamic_cast<Sketch::Nurb *>(s.Get(0));
+    bool ret = false;
+    if (nurb != 0) {
+	ret = (nurb->Order() == 3) &&
+	      !nurb->IsRational() &&
+	      (nurb->NumberOfControlPoints() == 3) &&
+	      (nurb->NumberOfKnots() == 6) &&
+	      VECTOR2D_EQUAL(nurb->StartPoint(), Vector2D(0.0, 0.0)) &&
+	      VECTOR2D_EQUAL(nurb->EndPoint(), Vector2D(2.0, 0.0));
+	nurb->Destroy();
+    }
+    return ret;
+}
+
+bool testSketchCompactMethod()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 0.0, 2.0, 0.0, 3.0, 0.0, 4.0, 0.0, 5.0, 0.0};
+    const int lines[] = {0, 1, 2, 3, 4, 5};
+    s.AppendLines(vertices, 6, lines, 3);
+    /* two of six vertices are unused, this isn't enough for an automatic compaction */
+    s.DeleteSegment(0);
+    const size_t verticesBefore = s.NumberOfVertices();
+    s.Compact();
+    return((verticesBefore == 6) &&
+	    (s.NumberOfVertices() == 4) &&
+	    (s.NumberOfSegments() == 2) &&
+	    segmentHasPoints(s, 0, Vector2D(2.0, 0.0), Vector2D(3.0, 0.0)) &&
+	    segmentHasPoints(s, 1, Vector2D(4.0, 0.0), Vector2D(5.0, 0.0)));
+}
+
+bool testSketchMovePointCompaction()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 0.0};
+    const int lines[] = {0, 1};
+    s.AppendLines(vertices, 2, lines, 1);
+    Sketch::Line *line = dynamic_cast<Sketch::Line *>(s.Get(0));
+    bool ret = false;
+    if (line != 0) {
+	/* every move leaves the former end point unused */
+	for (int i = 0; i < 100; ++i)
+	    line->SetEndPoint(Vector2D(1.0, 0.1 * (i + 1)));
+	ret = (s.NumberOfVertices() <= 4) &&
+	      VECTOR2D_EQUAL(line->StartPoint(), Vector2D(0.0, 0.0)) &&
+	      VECTOR2D_EQUAL(line->EndPoint(), Vector2D(1.0, 10.0));
+	line->Destroy();
+    }
+    return ret;
+}
+
+bool testSketchInsertSegmentReverseFlags()
+{
+    Sketch s = Sketch();
+    const double vertices[] = {0.0, 0.0, 1.0, 0.0, 1.0, 1.0};
+    const int lines[] = {0, 1, 1, 2};
+    s.AppendLines(vertices, 3, lines, 2);
+    Sketch::Segment *segment = s.Get(1);
+    if (segment != 0) {
+	segment->SetReverse(true);
+	segment->Destroy();
+    }
+    /* the reverse flags have to move with their segments */
+    Sketch::Line *line = s.InsertLine(0);
+    if (line != 0)
+	line->Destroy();
+    return((s.NumberOfSegments() == 3) &&
+	    !segmentIsReversed(s, 0) &&
+	    !segmentIsReversed(s, 1) &&
+	    segmentIsReversed(s, 2) &&
+	    segmentHasPoints(s, 2, Vector2D(1.0, 0.0), Vector2D(1.0, 1.0)));
+}
+
+void test_sketch(Database& database)
+{
+    bool allSketchTestsPassed = true;
+
+    /* Run tests */
+    std::cout << "Starting Sketch unit testing . . ." << std::endl;
+    ADD_TEST(testSketchAppendLinesWelding(), allSketchTestsPassed);
+    ADD_TEST(testSketchAppendArcsMethod(), allSketchTestsPassed);
+    ADD_TEST(testSketchAppendBeziersMethod(), allSketchTestsPassed);
+    ADD_TEST(testSketchAppendNurbsMethod(), allSketchTestsPassed);
+    ADD_TEST(testSketchCompactMethod(), allSketchTestsPassed);
+    ADD_TEST(testSketchMovePointCompaction(), allSketchTestsPassed);
+    ADD_TEST(testSketchInsertSegmentReverseFlags(), allSketchTestsPassed);
+
+    /* We only add a sketch to the database if it failed no tests */
+    if(allSketchTestsPassed) {
+	Sketch s = Sketch();
+	const double vertices[] = {0.0, 0.0, 100.0, 0.0, 100.0, 100.0, 0.0, 100.0};
+	const int lines[] = {0, 1, 1, 2, 2, 3, 3, 0};
+	s.AppendLines(vertices, 4, lines, 4);
+	s.SetName("Sketch.s");
+	std::cout << "All Sketch tests passed, adding object to database . . . " << std::endl;
+	database.Add(s);
+    }
+}
+
+
+/*
+ * Local Variables:
+ * mode: C++
+ * tab-width: 8
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */
@@ -0,0 +1,172 @@
+/*                 T R A N S A C T I O N . C P P
+ * BRL-CAD
+ *
+ * Copyright (c) 2015 United States Government as represented by
+ * the U.S. Army Research Laboratory.
+ *
+ * This library is free software; you can redistribute it and/or
+ * modify it under the terms of the GNU Lesser General Public License
+ * version 2.1 as published by the Free Software Foundation.
+ *
+ * This library is distributed in the hope that it will be useful, but
+ * WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the GNU
+ * Lesser General Public License for more details.
+ *
+ * You should have received a copy of the GNU Lesser General Public
+ * License along with this file; see the file named COPYING for more
+ * information.
+ */
+/** @file transaction.cpp
+ *
+ * BRL-CAD core C++ interface :
+ *		Unit tests for the transactions of the Database class
+ *
+ */
+
+#include <iostream>
+#include <brlcad/Sphere.h>
+#include "bn.h"
+#include "primitives.h"
+using namespace BRLCAD;
+
+#define ADD_TEST(expression, allTestsPassed)    \
+    if (!expression) {    \
+	std::cout << "Failed test: " << #expression << std::endl;    \
+	allTestsPassed = false;    \
+    } else {    \
+	std::cout << "Passed test: " << #expression << std::endl;    \
+    }
+
+class SetSphereCenter : public Database::ObjectCallback {
+public:
+    SetSphereCenter(const Vector3D& center) : Database::ObjectCallback(), m_center(center) {}
+
+    virtual void operator()(Object& object) {
+	Sphere* sphere = dynamic_cast<Sphere*>(&object);
+
+	if (sphere != 0)
+	    sphere->SetCenter(m_center);
+    }
+
+private:
+    Vector3D m_center;
+};
+
+class SetSphereRadius : public Database::ObjectCallback {
+public:
+    SetSphereRadius(double radius) : Database::ObjectCallback(), m_radius(radius) {}
+
+    virtual void operator()(Object& object) {
+	Sphere* sphere = dynamic_cast<Sphere*>(&object);
+
+	if (sphere != 0)
+	    sphere->SetRadius(m_radius);
+    }
+
+private:
+    double m_radius;
+};
+
+bool sphereInDatabase(const Database& database, const char* name, const Vector3D& center, double radius)
+{
+    Object* object = database.Get(name);
+    bool ret = false;
+    if (object != 0) {
+	Sphere* sphere = dynamic_cast<Sphere*>(object);
+	if (sphere != 0) {
+	    const Vector3D sphereCenter = sphere->Center();
+	    ret = EQUAL(sphereCenter.coordinates[0], center.coordinates[0]) &&
+		  EQUAL(sphereCenter.coordinates[1], center.coordinates[1]) &&
+		  EQUAL(sphereCenter.coordinates[2], center.coordinates[2]) &&
+		  EQUAL(sphere->Radius(), radius);
+	}
+	object->Destroy();
+    }
+    return ret;
+}
+
+/* Tests two edits of the same object in one transaction, the second one has to keep the first one */
+bool testTransactionTwoEdits(Database& database)
+{
+    Sphere sphere(Vector3D(0.0, 0.0, 0.0), 1.0);
+    sphere.SetName("TransactionEdits.s");
+    database.Add(sphere);
+    database.BeginTransaction();
+    SetSphereCenter setCenter(Vector3D(1.0, 2.0, 3.0));
+    SetSphereRadius setRadius(5.0);
+    bool ret = database.Get("TransactionEdits.s", setCenter) &&
+	       database.Get("TransactionEdits.s", setRadius) &&
+	       sphereInDatabase(database, "TransactionEdits.s", Vector3D(0.0, 0.0, 0.0), 1.0);
+    ret = database.Commit() && ret &&
+	  sphereInDatabase(database, "TransactionEdits.s", Vector3D(1.0, 2.0, 3.0), 5.0);
+    database.Delete("TransactionEdits.s");
+    return ret;
+}
+
+/* Tests Set() on an object added in the same transaction */
+bool testTransactionSetAdded(Database& database)
+{
+    database.BeginTransaction();
+    Sphere sphere(Vector3D(0.0, 0.0, 0.0), 1.0);
+    sphere.SetName("TransactionAdded.s");
+    database.Add(sphere);
+    sphere.Set(Vector3D(1.0, 1.0, 1.0), 2.0);
+    bool ret = database.Set(sphere) &&
+	       (database.Get("TransactionAdded.s") == 0);
+    ret = database.Commit() && ret &&
+	  sphereInDatabase(database, "TransactionAdded.s", Vector3D(1.0, 1.0, 1.0), 2.0);
+    database.Delete("TransactionAdded.s");
+    return ret;
+}
+
+/* Tests Set() on an object deleted in the same transaction */
+bool testTransactionSetDeleted(Database& database)
+{
+    Sphere sphere(Vector3D(0.0, 0.0, 0.0), 1.0);
+    sphere.SetName("TransactionDeleted.s");
+    database.Add(sphere);
+    database.BeginTransaction();
+    database.Delete("TransactionDeleted.s");
+    bool ret = !database.Set(sphere);
+    database.Rollback();
+    ret = ret && sphereInDatabase(database, "TransactionDeleted.s", Vector3D(0.0, 0.0, 0.0), 1.0);
+    database.Delete("TransactionDeleted.s");
+    return ret;
+}
+
+/* Tests Set() on a missing object */
+bool testSetMissing(Database& database)
+{
+    Sphere sphere(Vector3D(0.0, 0.0, 0.0), 1.0);
+    sphere.SetName("TransactionMissing.s");
+    return(!database.Set(sphere) &&
+	    (database.Get("TransactionMissing.s") == 0));
+}
+
+void test_transaction(Database& database)
+{
+    bool allTransactionTestsPassed = true;
+
+    /* Run tests */
+    std::cout << "Starting Transaction unit testing . . ." << std::endl;
+    ADD_TEST(testTransactionTwoEdits(database), allTransactionTestsPassed);
+    ADD_TEST(testTransactionSetAdded(database), allTransactionTestsPassed);
+    ADD_TEST(testTransactionSetDeleted(database), allTransactionTestsPassed);
+    ADD_TEST(testSetMissing(database), allTransactionTestsPassed);
+
+    if(allTransactionTestsPassed)
+	std::cout << "All Transaction tests passed" << std::endl;
+}
+
+
+/*
+ * Local Variables:
+ * mode: C++
+ * tab-width: 8
+ * c-basic-offset: 4
+ * indent-tabs-mode: t
+ * c-file-style: "stroustrup"
+ * End:
+ * ex: shiftwidth=4 tabstop=8
+ */